@@ -0,0 +1,218 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "plain/argparse.h"
+
+#include "bench.h"
+
+/*
+ * Parsing synthetic command lines (mixing short, long, aliased, and positional arguments)
+ */
+enum mixed_option { VERBOSE, OUTPUT, JOBS, FORCE, CONFIG, NUM_MIXED_OPTIONS };
+static const char* OUTPUT_ALIASES[] = {"out", "output-file", NULL};
+static const char* FORCE_ALIASES[] = {"overwrite", NULL};
+static const struct arg_config MIXED_CONFIGS[NUM_MIXED_OPTIONS] = {
+    [VERBOSE] = {.full_name = "verbose", .short_name = "v", .flag = true},
+    [OUTPUT] = {.full_name = "output", .short_name = "o", .aliases = OUTPUT_ALIASES},
+    [JOBS] = {.full_name = "jobs", .short_name = "j"},
+    [FORCE] = {.full_name = "force", .aliases = FORCE_ALIASES, .flag = true},
+    [CONFIG] = {.full_name = "config"},
+};
+// Every kind of flag token (and the number of tokens it takes, including the value)
+static const struct {
+    char* tokens[2];
+    int len;
+} MIXED_FLAGS[] = {
+    {{"-v"}, 1},
+    {{"--verbose"}, 1},
+    {{"-o", "out.txt"}, 2},
+    {{"--output-file", "out.txt"}, 2},
+    {{"--out=out.txt"}, 1},
+    {{"-j", "8"}, 2},
+    {{"--jobs=16"}, 1},
+    {{"--overwrite"}, 1},
+    {{"--force"}, 1},
+    {{"--config", "build.toml"}, 2},
+};
+enum { NUM_MIXED_FLAGS = sizeof(MIXED_FLAGS) / sizeof(MIXED_FLAGS[0]) };
+
+/*
+ * Generate a command line with `count` tokens (not including argv[0]).
+ *
+ * About 80% of the tokens are flags, followed by positional arguments.
+ */
+static char** mixed_args(int count, uint64_t seed) {
+    char** argv = calloc((size_t)count + 2, sizeof(char*));
+    argv[0] = "bench";
+    int idx = 1;
+    int num_flag_tokens = count - count / 5;
+    while (idx <= num_flag_tokens) {
+        int kind = (int)(bench_random(&seed) % NUM_MIXED_FLAGS);
+        if (idx + MIXED_FLAGS[kind].len - 1 > num_flag_tokens)
+            break;
+        for (int i = 0; i < MIXED_FLAGS[kind].len; i++) {
+            argv[idx++] = MIXED_FLAGS[kind].tokens[i];
+        }
+    }
+    while (idx <= count) {
+        argv[idx++] = "positional.c";
+    }
+    return argv;
+}
+
+static void bench_mixed_chain(char** argv, int argc, int rounds, const char* name) {
+    uint64_t start = bench_now_ns();
+    for (int round = 0; round < rounds; round++) {
+        struct arg_parser parser = init_args(argc, argv);
+        while (has_flag_args(&parser)) {
+            int matched = -1;
+            for (int i = 0; i < NUM_MIXED_OPTIONS; i++) {
+                if (match_arg(&parser, MIXED_CONFIGS[i].full_name, &MIXED_CONFIGS[i])) {
+                    matched = i;
+                    break;
+                }
+            }
+            if (matched < 0)
+                abort();
+            bench_consume((uint64_t)matched);
+        }
+        while (has_args(&parser)) {
+            bench_consume((uint64_t)(uintptr_t)consume_arg(&parser));
+        }
+    }
+    bench_report(name, bench_now_ns() - start, (uint64_t)(argc - 1) * (uint64_t)rounds, "token");
+}
+
+static void bench_mixed_table(char** argv, int argc, int rounds, const char* name) {
+    struct arg_table table = init_arg_table(MIXED_CONFIGS, NUM_MIXED_OPTIONS);
+    uint64_t start = bench_now_ns();
+    for (int round = 0; round < rounds; round++) {
+        struct arg_parser parser = init_args(argc, argv);
+        int matched;
+        while ((matched = match_arg_table(&parser, &table)) != ARG_TABLE_FINISHED) {
+            if (matched < 0)
+                abort();
+            bench_consume((uint64_t)matched);
+        }
+        while (has_args(&parser)) {
+            bench_consume((uint64_t)(uintptr_t)consume_arg(&parser));
+        }
+    }
+    bench_report(name, bench_now_ns() - start, (uint64_t)(argc - 1) * (uint64_t)rounds, "token");
+    free_arg_table(&table);
+}
+
+static void bench_mixed(void) {
+    static const int SIZES[] = {10, 1000, 100000};
+    for (size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++) {
+        int count = SIZES[i];
+        // Parse about two million tokens in total, for stable timings
+        int rounds = 2000000 / count;
+        char** argv = mixed_args(count, 0x5EED + (uint64_t)i);
+        char name[64];
+        snprintf(name, sizeof(name), "mixed/match_arg chain (%d args)", count);
+        bench_mixed_chain(argv, count + 1, rounds, name);
+        snprintf(name, sizeof(name), "mixed/arg_table (%d args)", count);
+        bench_mixed_table(argv, count + 1, rounds, name);
+        free(argv);
+    }
+}
+
+/*
+ * Compares long name lookup with a `struct arg_table` (perfect hash)
+ * against chaining one `match_arg` per option (walking every name & alias).
+ */
+enum { NUM_CONFIGS = 300, NUM_ALIASES = 2, NUM_TOKENS = 10000, LOOKUP_ROUNDS = 20 };
+
+static char NAMES[NUM_CONFIGS][NUM_ALIASES + 1][32];
+static const char* ALIASES[NUM_CONFIGS][NUM_ALIASES + 1];
+static struct arg_config CONFIGS[NUM_CONFIGS];
+
+static void init_configs(void) {
+    for (int i = 0; i < NUM_CONFIGS; i++) {
+        snprintf(NAMES[i][0], sizeof(NAMES[i][0]), "some-long-option-%d", i);
+        for (int j = 0; j < NUM_ALIASES; j++) {
+            snprintf(NAMES[i][j + 1], sizeof(NAMES[i][j + 1]), "some-long-alias-%d-%d", i, j);
+            ALIASES[i][j] = NAMES[i][j + 1];
+        }
+        ALIASES[i][NUM_ALIASES] = NULL;
+        CONFIGS[i] = (struct arg_config){.full_name = NAMES[i][0], .aliases = ALIASES[i], .flag = true};
+    }
+}
+
+static char** random_long_flags(int count, uint64_t seed) {
+    char** argv = calloc((size_t)count + 2, sizeof(char*));
+    argv[0] = "bench";
+    for (int i = 1; i <= count; i++) {
+        uint64_t r = bench_random(&seed);
+        int config = (int)(r % NUM_CONFIGS);
+        int name = (int)((r >> 32) % (NUM_ALIASES + 1));
+        char* flag = malloc(40);
+        snprintf(flag, 40, "--%s", NAMES[config][name]);
+        argv[i] = flag;
+    }
+    return argv;
+}
+
+static void bench_alias_walk(char** argv, int argc) {
+    uint64_t start = bench_now_ns();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        struct arg_parser parser = init_args(argc, argv);
+        while (has_flag_args(&parser)) {
+            int matched = -1;
+            for (int i = 0; i < NUM_CONFIGS; i++) {
+                if (match_arg(&parser, CONFIGS[i].full_name, &CONFIGS[i])) {
+                    matched = i;
+                    break;
+                }
+            }
+            if (matched < 0)
+                abort();
+            bench_consume((uint64_t)matched);
+        }
+    }
+    bench_report("lookup/match_arg chain (300 options)", bench_now_ns() - start, (uint64_t)(argc - 1) * LOOKUP_ROUNDS,
+                 "token");
+}
+
+static void bench_table(char** argv, int argc) {
+    struct arg_table table = init_arg_table(CONFIGS, NUM_CONFIGS);
+    uint64_t start = bench_now_ns();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        struct arg_parser parser = init_args(argc, argv);
+        int matched;
+        while ((matched = match_arg_table(&parser, &table)) != ARG_TABLE_FINISHED) {
+            if (matched < 0)
+                abort();
+            bench_consume((uint64_t)matched);
+        }
+    }
+    bench_report("lookup/arg_table (300 options)", bench_now_ns() - start, (uint64_t)(argc - 1) * LOOKUP_ROUNDS,
+                 "token");
+    free_arg_table(&table);
+}
+
+static void bench_table_init(void) {
+    enum { INIT_ROUNDS = 100 };
+    uint64_t start = bench_now_ns();
+    for (int round = 0; round < INIT_ROUNDS; round++) {
+        struct arg_table table = init_arg_table(CONFIGS, NUM_CONFIGS);
+        bench_consume(table.displacements[0]);
+        free_arg_table(&table);
+    }
+    bench_report("lookup/init_arg_table (300 options)", bench_now_ns() - start, INIT_ROUNDS, "table");
+}
+
+int main(void) {
+    bench_mixed();
+    init_configs();
+    char** argv = random_long_flags(NUM_TOKENS, 0x5EED);
+    bench_alias_walk(argv, NUM_TOKENS + 1);
+    bench_table(argv, NUM_TOKENS + 1);
+    bench_table_init();
+    for (int i = 1; i <= NUM_TOKENS; i++) {
+        free(argv[i]);
+    }
+    free(argv);
+    return 0;
+}
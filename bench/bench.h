@@ -0,0 +1,50 @@
+/*
+ * Tiny helpers shared by the plainlibs benchmarks.
+ *
+ * These intentionally only depend on the C11 standard library (not Criterion),
+ * so the benchmarks can run on any machine.
+ */
+#ifndef PLAINLIBS_BENCH_H
+#define PLAINLIBS_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * The current time (in nanoseconds).
+ *
+ * Uses C11 timespec_get, which is available on both POSIX and MSVC.
+ */
+static inline uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ((uint64_t)ts.tv_sec) * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Results are stored here, so the compiler can't optimize away the benchmarked code.
+ */
+static volatile uint64_t bench_sink;
+
+static inline void bench_consume(uint64_t value) {
+    bench_sink += value;
+}
+
+/*
+ * Simple xorshift64 PRNG, for reproducible inputs.
+ */
+static inline uint64_t bench_random(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static inline void bench_report(const char* name, uint64_t elapsed_ns, uint64_t count, const char* unit) {
+    printf("%-48s %10.2f ns/%s\n", name, (double)elapsed_ns / (double)count, unit);
+}
+
+#endif /* PLAINLIBS_BENCH_H */
@@ -0,0 +1,131 @@
+#include <stdlib.h>
+
+#include "plain/intbuiltins.h"
+
+#include "bench.h"
+
+enum { NUM_INPUTS = 1 << 16, ROUNDS = 200 };
+
+static uint32_t INPUTS32[NUM_INPUTS];
+static uint64_t INPUTS64[NUM_INPUTS];
+
+/*
+ * Fill the inputs with either uniformly random values or values with a random bit length.
+ *
+ * Uniformly random values almost always have nlz of 0 or 1 (so branches are predictable).
+ * Values with a random bit length are skewed towards small magnitudes,
+ * giving uniformly distributed nlz (so branches are unpredictable).
+ */
+static void fill_inputs(bool skewed) {
+    uint64_t seed = 0x5EED;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        uint64_t value = bench_random(&seed);
+        uint32_t value32 = (uint32_t)(value >> 32);
+        if (skewed) {
+            uint64_t shift = bench_random(&seed);
+            value >>= shift % 64;
+            value32 >>= (shift >> 32) % 32;
+        }
+        // nlz(0) is undefined for the builtins
+        INPUTS64[i] = value | 1;
+        INPUTS32[i] = value32 | 1;
+    }
+}
+
+#define BENCH_NLZ(func, inputs, name)                                                    \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                total += (uint64_t)func(inputs[i]);                                      \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HAVE_GNU_BUILTINS
+static inline int builtin_clz32(uint32_t x) {
+    return __builtin_clz(x);
+}
+static inline int builtin_clz64(uint64_t x) {
+    return __builtin_clzll((unsigned long long)x);
+}
+#endif
+
+static void bench_nlz(bool skewed) {
+    fill_inputs(skewed);
+    printf("nlz (%s inputs):\n", skewed ? "skewed" : "uniform");
+    BENCH_NLZ(_plain_int_nlz32_simple, INPUTS32, "  nlz32/simple");
+    BENCH_NLZ(_plain_int_nlz32_branchless, INPUTS32, "  nlz32/branchless");
+    BENCH_NLZ(_plain_int_nlz32_debruijn, INPUTS32, "  nlz32/debruijn");
+#ifdef HAVE_GNU_BUILTINS
+    BENCH_NLZ(builtin_clz32, INPUTS32, "  nlz32/__builtin_clz");
+#endif
+    BENCH_NLZ(_plain_int_nlz64_simple, INPUTS64, "  nlz64/simple");
+    BENCH_NLZ(_plain_int_nlz64_branchless, INPUTS64, "  nlz64/branchless");
+    BENCH_NLZ(_plain_int_nlz64_debruijn, INPUTS64, "  nlz64/debruijn");
+#ifdef HAVE_GNU_BUILTINS
+    BENCH_NLZ(builtin_clz64, INPUTS64, "  nlz64/__builtin_clzll");
+#endif
+}
+
+static int64_t MUL_FIRST[NUM_INPUTS];
+static int64_t MUL_SECOND[NUM_INPUTS];
+
+/*
+ * Fill the multiplication inputs with values of either at most 31 bits,
+ * or 32-40 bits (so both operands are "large" and roughly half the products overflow).
+ */
+static void fill_mul_inputs(bool large) {
+    uint64_t seed = 0xABCD;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        uint64_t a = bench_random(&seed), b = bench_random(&seed);
+        int shift_a = large ? 24 + (int)(a % 9) : 33;
+        int shift_b = large ? 24 + (int)(b % 9) : 33;
+        int64_t first = (int64_t)(a >> shift_a), second = (int64_t)(b >> shift_b);
+        MUL_FIRST[i] = (a & 1) ? -first : first;
+        MUL_SECOND[i] = (b & 2) ? -second : second;
+    }
+}
+
+#define BENCH_MUL(func, name)                                                            \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                int64_t res;                                                             \
+                bool overflow = func(MUL_FIRST[i], MUL_SECOND[i], &res);                 \
+                total += (uint64_t)res + overflow;                                       \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+#ifdef HAVE_GNU_BUILTINS
+static inline bool builtin_mul_overflow64(int64_t first, int64_t second, int64_t* res) {
+    return __builtin_mul_overflow(first, second, res);
+}
+#endif
+
+static void bench_mul(bool large) {
+    fill_mul_inputs(large);
+    printf("overflowing_mul64s (%s inputs):\n", large ? "large" : "small");
+    BENCH_MUL(_plain_int_overflowing_mul64s_division, "  mul64s/division");
+    BENCH_MUL(_plain_int_overflowing_mul64s_fallback, "  mul64s/fallback");
+#ifdef HAVE_GNU_BUILTINS
+    BENCH_MUL(builtin_mul_overflow64, "  mul64s/__builtin_mul_overflow");
+#endif
+}
+
+int main(void) {
+    bench_nlz(false);
+    bench_nlz(true);
+    bench_mul(false);
+    bench_mul(true);
+    return 0;
+}
@@ -0,0 +1,284 @@
+#include <stdlib.h>
+
+#include "plain/intmath.h"
+
+#include "bench.h"
+
+enum { NUM_INPUTS = 1 << 14, ROUNDS = 200 };
+
+static int64_t BASES[NUM_INPUTS];
+static uint32_t EXPS[NUM_INPUTS];
+
+/*
+ * Sweep bases with a random bit length (and sign) against exponents up to `max_exp`.
+ *
+ * With small exponents most results fit, with large ones almost all overflow.
+ */
+static void fill_inputs(uint32_t max_exp) {
+    uint64_t seed = 0xBA5E;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        uint64_t value = bench_random(&seed);
+        int64_t base = (int64_t)((value >> 1) >> (value % 63));
+        BASES[i] = (value & (UINT64_C(1) << 62)) ? -base : base;
+        EXPS[i] = (uint32_t)(bench_random(&seed) % (max_exp + 1));
+    }
+}
+
+static bool pow64s_saturating(int64_t base, uint32_t exp, int64_t* res) {
+    *res = plain_int_pow64s_saturating(base, exp);
+    return false;
+}
+
+static bool pow64s_checked(int64_t base, uint32_t exp, int64_t* res) {
+    struct plain_int_checked ctx = PLAIN_INT_CHECKED_INIT;
+    *res = plain_int_checked_pow64s(&ctx, base, exp);
+    return ctx.overflowed;
+}
+
+#define BENCH_POW(func, name)                                                            \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                int64_t res;                                                             \
+                bool overflow = func(BASES[i], EXPS[i], &res);                           \
+                total += (uint64_t)res + overflow;                                       \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+static void bench_pow(uint32_t max_exp) {
+    fill_inputs(max_exp);
+    int overflows = 0;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        int64_t ignored;
+        overflows += plain_int_pow64s_overflowing(BASES[i], EXPS[i], &ignored);
+    }
+    printf("pow64s (exponents up to %u, %d%% overflow):\n", (unsigned)max_exp, overflows * 100 / NUM_INPUTS);
+    // Checks each multiplication, so it runs the whole loop even after overflow
+    BENCH_POW(plain_int_pow64s_overflowing, "  pow64s_overflowing");
+    // These look up the maximum base instead
+    BENCH_POW(pow64s_checked, "  checked_pow64s");
+    BENCH_POW(pow64s_saturating, "  pow64s_saturating");
+}
+
+/*
+ * Compare the generic loop and the addition chains for a constant exponent.
+ *
+ * The loop is inlined with the same constant, so it's up to the compiler to unroll it.
+ */
+#define BENCH_POW_CONST(exp)                                                              \
+    do {                                                                                  \
+        printf("pow64s (constant exponent %d):\n", exp);                                   \
+        BENCH_POW_CONST_IMPL(plain_int_pow64s_overflowing(BASES[i], exp, &res), "  loop"); \
+        BENCH_POW_CONST_IMPL(PLAIN_INT_POW64S_OVERFLOWING_CONST(BASES[i], exp, &res),      \
+                             "  addition chain");                                         \
+    } while (false)
+
+#define BENCH_POW_CONST_IMPL(expr, name)                                                 \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                int64_t res;                                                             \
+                bool overflow = expr;                                                    \
+                total += (uint64_t)res + overflow;                                       \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+/*
+ * Counting digits by dividing, for comparison.
+ */
+static int digits_division_loop(uint64_t val) {
+    int digits = 1;
+    while (val >= 10) {
+        val /= 10;
+        digits += 1;
+    }
+    return digits;
+}
+
+#define BENCH_DIGITS(func, name)                                                         \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                total += (uint64_t)func((uint64_t)BASES[i]);                             \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+/*
+ * Read the divisors at runtime, so the compiler can't precompute them itself.
+ */
+static volatile uint64_t DIVISOR64 = 1000000007;
+static volatile uint32_t DIVISOR32 = 641;
+
+static uint64_t NUMERATORS[NUM_INPUTS], QUOTIENTS[NUM_INPUTS];
+static uint32_t NUMERATORS32[NUM_INPUTS], QUOTIENTS32[NUM_INPUTS];
+
+static void fill_numerators(void) {
+    uint64_t seed = 0xD1CE;
+    for (int i = 0; i < NUM_INPUTS; i++) {
+        NUMERATORS[i] = bench_random(&seed);
+        NUMERATORS32[i] = (uint32_t) NUMERATORS[i];
+    }
+}
+
+#define BENCH_DIV(tp, numerators, expr, name)                                            \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                tp val = (tp)numerators[i];                                              \
+                total += (uint64_t)(expr);                                               \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+#define BENCH_DIV_BATCH(stmt, out, name)                                                 \
+    do {                                                                                 \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            stmt;                                                                        \
+            total += (uint64_t)out[round];                                               \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+static void bench_dividers(void) {
+    fill_numerators();
+    uint32_t d32 = DIVISOR32;
+    uint64_t d64 = DIVISOR64;
+    int64_t d64s = -(int64_t)DIVISOR64;
+    struct plain_int_divider32u div32u = plain_int_divider32u_new(d32);
+    struct plain_int_divider64u div64u = plain_int_divider64u_new(d64);
+    struct plain_int_divider64s div64s = plain_int_divider64s_new(d64s);
+    printf("divide by %u (32u):\n", (unsigned)d32);
+    BENCH_DIV(uint32_t, NUMERATORS32, val / d32, "  native /");
+    BENCH_DIV(uint32_t, NUMERATORS32, plain_int_divider32u_div(&div32u, val), "  divider32u_div");
+    BENCH_DIV(uint32_t, NUMERATORS32, val % d32, "  native %");
+    BENCH_DIV(uint32_t, NUMERATORS32, plain_int_divider32u_mod(&div32u, val), "  divider32u_mod");
+    BENCH_DIV(uint32_t, NUMERATORS32, val % d32 == 0, "  native % == 0");
+    BENCH_DIV(uint32_t, NUMERATORS32, plain_int_divider32u_divisible(&div32u, val), "  divider32u_divisible");
+    BENCH_DIV_BATCH(for (int i = 0; i < NUM_INPUTS; i++) QUOTIENTS32[i] = NUMERATORS32[i] / d32, QUOTIENTS32,
+                    "  native / (array)");
+    BENCH_DIV_BATCH(plain_int_divider32u_div_batch(&div32u, NUMERATORS32, QUOTIENTS32, NUM_INPUTS), QUOTIENTS32,
+                    "  divider32u_div_batch");
+    printf("divide by %llu (64u):\n", (unsigned long long)d64);
+    BENCH_DIV(uint64_t, NUMERATORS, val / d64, "  native /");
+    BENCH_DIV(uint64_t, NUMERATORS, plain_int_divider64u_div(&div64u, val), "  divider64u_div");
+    BENCH_DIV(uint64_t, NUMERATORS, val % d64, "  native %");
+    BENCH_DIV(uint64_t, NUMERATORS, plain_int_divider64u_mod(&div64u, val), "  divider64u_mod");
+    BENCH_DIV(uint64_t, NUMERATORS, val % d64 == 0, "  native % == 0");
+    BENCH_DIV(uint64_t, NUMERATORS, plain_int_divider64u_divisible(&div64u, val), "  divider64u_divisible");
+    BENCH_DIV_BATCH(for (int i = 0; i < NUM_INPUTS; i++) QUOTIENTS[i] = NUMERATORS[i] / d64, QUOTIENTS,
+                    "  native / (array)");
+    BENCH_DIV_BATCH(plain_int_divider64u_div_batch(&div64u, NUMERATORS, QUOTIENTS, NUM_INPUTS), QUOTIENTS,
+                    "  divider64u_div_batch");
+    printf("divide by %lld (64s):\n", (long long)d64s);
+    BENCH_DIV(int64_t, NUMERATORS, val / d64s, "  native /");
+    BENCH_DIV(int64_t, NUMERATORS, plain_int_divider64s_div(&div64s, val), "  divider64s_div");
+    BENCH_DIV(int64_t, NUMERATORS, val % d64s, "  native %");
+    BENCH_DIV(int64_t, NUMERATORS, plain_int_divider64s_mod(&div64s, val), "  divider64s_mod");
+}
+
+/*
+ * The usual workaround for `a * b / c` overflowing, for comparison.
+ *
+ * This is only exact if long double has a 64 bit mantissa (x87), and even then the result is truncated twice.
+ */
+static uint64_t mul_div_long_double(uint64_t a, uint64_t b, uint64_t c) {
+    return (uint64_t)((long double)a * (long double)b / (long double)c);
+}
+
+static uint64_t mul_div64u(uint64_t a, uint64_t b, uint64_t c) {
+    uint64_t res;
+    (void)plain_int_mul_div64u(a, b, c, PLAIN_INT_ROUND_TOWARD_ZERO, &res);
+    return res;
+}
+
+static uint64_t mul_div64u_nearest(uint64_t a, uint64_t b, uint64_t c) {
+    uint64_t res;
+    (void)plain_int_mul_div64u(a, b, c, PLAIN_INT_ROUND_NEAREST, &res);
+    return res;
+}
+
+static uint64_t mul_q64s(uint64_t a, uint64_t b, uint64_t c) {
+    (void)c;
+    int64_t res;
+    (void)plain_int_mul_q64s((int64_t)a, (int64_t)b, 32, PLAIN_INT_ROUND_NEAREST, &res);
+    return (uint64_t)res;
+}
+
+/*
+ * Scale ticks of a 24 MHz clock to nanoseconds.
+ *
+ * With `shift` = 6 the products need up to 94 bits (but the results still fit),
+ * while with `shift` = 34 they all fit in 64 bits.
+ */
+#define BENCH_MUL_DIV(func, shift, name)                                                 \
+    do {                                                                                 \
+        uint64_t b = MUL_DIV_B, c = MUL_DIV_C;                                           \
+        uint64_t start = bench_now_ns();                                                 \
+        uint64_t total = 0;                                                              \
+        for (int round = 0; round < ROUNDS; round++) {                                   \
+            for (int i = 0; i < NUM_INPUTS; i++) {                                       \
+                total += func(NUMERATORS[i] >> (shift), b, c);                           \
+            }                                                                            \
+        }                                                                                \
+        bench_consume(total);                                                            \
+        bench_report(name, bench_now_ns() - start, (uint64_t)NUM_INPUTS * ROUNDS, "op"); \
+    } while (false)
+
+static volatile uint64_t MUL_DIV_B = 1000000000, MUL_DIV_C = 24000000;
+
+static void bench_mul_div(void) {
+    fill_numerators();
+    printf("mul_div64u (128 bit product):\n");
+    BENCH_MUL_DIV(mul_div_long_double, 6, "  long double");
+    BENCH_MUL_DIV(mul_div64u, 6, "  mul_div64u");
+    BENCH_MUL_DIV(mul_div64u_nearest, 6, "  mul_div64u (nearest)");
+    printf("mul_div64u (64 bit product):\n");
+    BENCH_MUL_DIV(mul_div_long_double, 34, "  long double");
+    BENCH_MUL_DIV(mul_div64u, 34, "  mul_div64u");
+    printf("mul_q64s (Q32.32):\n");
+    BENCH_MUL_DIV(mul_q64s, 6, "  mul_q64s");
+}
+
+int main(void) {
+    bench_pow(2);
+    bench_pow(4);
+    bench_pow(16);
+    bench_pow(64);
+    bench_pow(1000);
+    fill_inputs(0);
+    BENCH_POW_CONST(2);
+    BENCH_POW_CONST(3);
+    BENCH_POW_CONST(5);
+    BENCH_POW_CONST(10);
+    BENCH_POW_CONST(15);
+    BENCH_POW_CONST(18);
+    // The bases have a random bit length, so a random number of digits
+    printf("decimal_digits64u:\n");
+    BENCH_DIGITS(digits_division_loop, "  division loop");
+    BENCH_DIGITS(plain_int_decimal_digits64u, "  decimal_digits64u");
+    bench_dividers();
+    bench_mul_div();
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+
+#include "plain/intvec.h"
+
+#include "bench.h"
+
+enum { LEN = 4096, ROUNDS = 5000 };
+
+/*
+ * Read the length at runtime like real code would.
+ *
+ * A constant length lets GCC fully unroll the tails,
+ * which also gives spurious -Waggressive-loop-optimizations warnings.
+ */
+static volatile size_t BENCH_LEN = LEN;
+
+static int32_t FIRST32[LEN], SECOND32[LEN], OUT32[LEN];
+static int64_t FIRST64[LEN], SECOND64[LEN], OUT64[LEN];
+
+static void fill_inputs(void) {
+    uint64_t seed = 0xC0FFEE;
+    for (int i = 0; i < LEN; i++) {
+        uint64_t value = bench_random(&seed);
+        // Small enough that nothing overflows (the common case)
+        FIRST32[i] = (int32_t) (value >> 48) - 32768;
+        SECOND32[i] = (int32_t) ((value >> 32) & 0xFFFF) - 32768;
+        FIRST64[i] = (int64_t) (value >> 8) - (INT64_C(1) << 55);
+        SECOND64[i] = (int64_t) (bench_random(&seed) >> 8) - (INT64_C(1) << 55);
+    }
+}
+
+#define BENCH_ELEMENTWISE(func, first, second, out, name)                           \
+    do {                                                                            \
+        uint64_t start = bench_now_ns();                                            \
+        uint64_t total = 0;                                                         \
+        for (int round = 0; round < ROUNDS; round++) {                              \
+            total += func(first, second, out, BENCH_LEN);                           \
+            total += (uint64_t) out[round % LEN];                                   \
+        }                                                                           \
+        bench_consume(total);                                                       \
+        bench_report(name, bench_now_ns() - start, (uint64_t) LEN * ROUNDS, "elem"); \
+    } while (false)
+
+// Adapts the scalar versions to the public signature
+static size_t scalar_add32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    return _plain_intvec_add32s_scalar(first, second, out, 0, n);
+}
+static size_t scalar_mul32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    return _plain_intvec_mul32s_scalar(first, second, out, 0, n);
+}
+static size_t scalar_add64s(const int64_t *first, const int64_t *second, int64_t *out, size_t n) {
+    return _plain_intvec_add64s_scalar(first, second, out, 0, n);
+}
+
+static size_t sum64s(const int64_t *values, const int64_t *unused, int64_t *out, size_t n) {
+    (void) unused;
+    return plain_intvec_sum64s(values, n, out);
+}
+static size_t scalar_sum64s(const int64_t *values, const int64_t *unused, int64_t *out, size_t n) {
+    (void) unused;
+    int64_t sum = 0;
+    bool overflow = false;
+    for (size_t i = 0; i < n; i++) {
+        overflow |= plain_int_overflowing_add64s(sum, values[i], &sum);
+    }
+    *out = sum;
+    return overflow;
+}
+static size_t dot32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    int64_t res;
+    bool overflow = plain_intvec_dot32s(first, second, n, &res);
+    *out = (int32_t) res;
+    return overflow;
+}
+static size_t scalar_dot32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    int64_t sum = 0;
+    bool overflow = false;
+    for (size_t i = 0; i < n; i++) {
+        overflow |= plain_int_overflowing_add64s(sum, ((int64_t) first[i]) * second[i], &sum);
+    }
+    *out = (int32_t) sum;
+    return overflow;
+}
+
+int main(void) {
+    fill_inputs();
+#if defined(_PLAIN_INTVEC_AVX2_DISPATCH)
+    printf("SIMD dispatched at runtime (AVX2 %s)\n", PLAIN_CPU_HAS_AVX2() ? "supported" : "unsupported");
+#elif defined(_PLAIN_INTVEC_ISA)
+    printf("SIMD enabled (%d x 32 bit lanes)\n", _PLAIN_INTVEC_LANES32);
+#else
+    printf("SIMD disabled\n");
+#endif
+    BENCH_ELEMENTWISE(plain_intvec_add32s, FIRST32, SECOND32, OUT32, "add32s");
+    BENCH_ELEMENTWISE(scalar_add32s, FIRST32, SECOND32, OUT32, "add32s/scalar");
+    BENCH_ELEMENTWISE(plain_intvec_mul32s, FIRST32, SECOND32, OUT32, "mul32s");
+    BENCH_ELEMENTWISE(scalar_mul32s, FIRST32, SECOND32, OUT32, "mul32s/scalar");
+    BENCH_ELEMENTWISE(plain_intvec_add64s, FIRST64, SECOND64, OUT64, "add64s");
+    BENCH_ELEMENTWISE(scalar_add64s, FIRST64, SECOND64, OUT64, "add64s/scalar");
+    BENCH_ELEMENTWISE(sum64s, FIRST64, SECOND64, OUT64, "sum64s");
+    BENCH_ELEMENTWISE(scalar_sum64s, FIRST64, SECOND64, OUT64, "sum64s/scalar");
+    BENCH_ELEMENTWISE(dot32s, FIRST32, SECOND32, OUT32, "dot32s");
+    BENCH_ELEMENTWISE(scalar_dot32s, FIRST32, SECOND32, OUT32, "dot32s/scalar");
+    return 0;
+}
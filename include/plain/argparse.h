@@ -3,6 +3,8 @@
  *
  * No documentation (yet), just read the source.
  *
+ * Requires "intbuiltins.h" (for parsing integer values)
+ *
  * Dual-licensed under Creative Commons CC0 (Public Domain) and the MIT License.
  *
  * Source code & issue tracker: https://github.com/Techcable/plainlibs
@@ -13,28 +15,192 @@
  *
  * NEXT:
  *    - Fixed assertion to allow single-char flags (ex: -x)
+ *    - Added `struct arg_table` to match every argument in a single pass over argv
+ *    - Long names in `struct arg_table` are found with a perfect hash (one hash & one compare)
+ *    - Cache the classification of the current argument (avoiding repeated strlen calls)
+ *    - Support `--name=value` (without copying) and bundled short flags (ex: -xvf)
+ *        - BREAKING: `-name` is now a bundle of short flags, instead of an error
+ *    - Added overflow-checked integer parsing for values (ex: `current_value_int64`)
+ *    - Added opt-in expansion of `@path` response files (memory-mapped & tokenized in place)
+ *    - Added opt-in `return_errors` mode, which records errors in the parser instead of exiting
+ *    - Added `match_subcommand` for git-style subcommands (with unique-prefix matching)
+ *    - Added `consume_remaining_args` and `consume_args_chunk` to consume positional arguments in bulk
  * 0.1.0-beta.2:
  *    - Corrected support for positional arguments (and --)
  * 0.1.0-beta.1 - Initial release
  */
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+// Used to memory-map response files
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define _ARG_HAVE_MMAP 1
+#endif
+
+#include "plain/intbuiltins.h"
+
 #define _ARG_UNREACHABLE()       \
     do {                         \
         assert(false);           \
         __builtin_unreachable(); \
     } while (false)
 
+/*
+ * The kind of the current argument, as classified by `_arg_classify`.
+ *
+ * Bundled short flags (like "-xvf") are ARG_KIND_SHORT,
+ * and are matched one character at a time.
+ */
+enum arg_kind {
+    // A positional argument (including "-" and the empty string)
+    ARG_KIND_POSITIONAL,
+    // A short flag like "-k"
+    ARG_KIND_SHORT,
+    // A long flag like "--name" (or "--name=value")
+    ARG_KIND_LONG,
+    // The "--" separator, which delimits the positional arguments
+    ARG_KIND_SEPARATOR,
+};
+
+/*
+ * The maximum nesting of response files (`@path` inside of another response file).
+ *
+ * This also stops a response file that includes itself from recursing forever.
+ */
+#ifndef ARG_RESPONSE_FILE_MAX_DEPTH
+#define ARG_RESPONSE_FILE_MAX_DEPTH 16
+#endif
+
+/*
+ * An open response file, which is tokenized lazily (and in place).
+ *
+ * The file is memory-mapped (copy-on-write) where possible,
+ * otherwise it is read into a single buffer.
+ * Either way, there is no allocation for individual arguments.
+ */
+struct arg_response_file {
+    char* data;
+    size_t size;
+    // Offset of the next untokenized byte
+    size_t offset;
+    // The current token, or NULL if it needs to be read
+    char* token;
+    // A copy of the final token, if it has no room for its null terminator
+    char* tail_token;
+    bool mapped;
+    // The response file that included this one (NULL if this came from argv)
+    struct arg_response_file* parent;
+    // The previously opened response file (so everything can be freed by `free_args`)
+    struct arg_response_file* previous_opened;
+};
+
+/*
+ * The kind of error encountered by the parser.
+ */
+enum arg_error_kind {
+    ARG_ERROR_NONE = 0,
+    // A value argument (like `--name value`) was the last argument
+    ARG_ERROR_MISSING_VALUE,
+    // A flag was given a value (like `--flag=value`)
+    ARG_ERROR_UNEXPECTED_VALUE,
+    // A response file could not be read
+    ARG_ERROR_RESPONSE_FILE,
+    // Response files were nested more than ARG_RESPONSE_FILE_MAX_DEPTH deep
+    ARG_ERROR_RESPONSE_FILE_DEPTH,
+    // A response file has an unterminated quote
+    ARG_ERROR_RESPONSE_FILE_SYNTAX,
+    // Unable to allocate memory (for a response file)
+    ARG_ERROR_OUT_OF_MEMORY,
+};
+
+// Maximum length of `struct arg_error.name` (including the null terminator)
+#ifndef ARG_ERROR_MAX_NAME
+#define ARG_ERROR_MAX_NAME 64
+#endif
+
+/*
+ * An error encountered by the parser (only used in `return_errors` mode).
+ *
+ * This is fixed-size, so recording an error never allocates.
+ */
+struct arg_error {
+    enum arg_error_kind kind;
+    /*
+     * The index in argv of the argument that caused the error.
+     *
+     * For arguments from a response file, this is the index of the outermost `@path` argument.
+     */
+    int idx;
+    // The name of the option (or the path of the response file), truncated to fit
+    char name[ARG_ERROR_MAX_NAME];
+};
+
 struct arg_parser {
     int idx;
     int argc;
     char** argv;
+    /*
+     * The value of the last matched argument (or NULL if it was a flag).
+     *
+     * This points either into argv (even for `--name=value`)
+     * or into a response file (see `expand_response_files`).
+     * It is always null terminated, but is only valid until `free_args` is called.
+     */
     char* current_value;
+    size_t current_value_len;
     bool finished_flags;
+    /*
+     * Cached classification of the current argument.
+     *
+     * This avoids repeatedly calling strlen on the same argument
+     * when trying to match many different flags.
+     * It is invalidated by `consume_arg`.
+     */
+    bool classified;
+    enum arg_kind current_kind;
+    // Length of the current long name (excluding the leading `--` and any `=value`)
+    size_t current_name_len;
+    // The value of `--name=value`, or NULL if there is no `=`
+    char* current_inline_value;
+    // Offset of the current short flag, within a bundle like `-xvf`
+    size_t short_offset;
+    /*
+     * If true, an argument like `@path` is replaced with the arguments in the file at `path`.
+     *
+     * Arguments in the file are separated by whitespace,
+     * and may be quoted (with ' or ") or escaped with a backslash.
+     * An unterminated quote is an error (ARG_ERROR_RESPONSE_FILE_SYNTAX).
+     * The file may contain nested `@path` arguments (up to ARG_RESPONSE_FILE_MAX_DEPTH).
+     *
+     * This is off by default (`@` is not special).
+     * Arguments (and values) from response files are valid until `free_args` is called.
+     */
+    bool expand_response_files;
+    int response_depth;
+    // The innermost response file, or NULL if arguments are coming from argv
+    struct arg_response_file* response_file;
+    // The most recently opened response file (including ones that are finished)
+    struct arg_response_file* last_opened_response_file;
+    /*
+     * If true, errors are recorded in `error` instead of printing a message and exiting.
+     *
+     * Once an error occurs, the parser behaves as if there are no more arguments
+     * (so `has_args` and `has_flag_args` return false, and `match_arg` fails).
+     * Check `error.kind` after parsing.
+     *
+     * This is off by default. It never uses stdio or allocates memory (for errors).
+     */
+    bool return_errors;
+    struct arg_error error;
 };
 struct arg_config {
     // Short name for this argument
@@ -43,10 +209,319 @@ struct arg_config {
     const char** aliases;
     // True if this argument is a flag, false if it is a value
     bool flag;
+    // Full name of this argument (without the leading `--`)
+    //
+    // Only used by `struct arg_table`, `match_arg` takes the name as a parameter.
+    const char* full_name;
 };
 
+/*
+ * The index in argv of the current argument (see `struct arg_error.idx`).
+ */
+static inline int _arg_current_idx(struct arg_parser* parser) {
+    if (parser->response_file == NULL) {
+        return parser->idx;
+    } else {
+        // Skip over the outermost `@path` argument
+        return parser->idx - 1;
+    }
+}
+
+/*
+ * Report an error, either by exiting (the default) or recording it in the parser.
+ *
+ * Always returns false, so it can be used as `return _arg_fail(...)`.
+ */
+static bool _arg_fail(struct arg_parser* parser, enum arg_error_kind kind, int idx, const char* name) {
+    assert(kind != ARG_ERROR_NONE);
+    if (!parser->return_errors) {
+        switch (kind) {
+            case ARG_ERROR_MISSING_VALUE:
+                fprintf(stderr, "ERROR: Expected a value for --%s\n", name);
+                break;
+            case ARG_ERROR_UNEXPECTED_VALUE:
+                fprintf(stderr, "ERROR: The flag --%s doesn't take a value\n", name);
+                break;
+            case ARG_ERROR_RESPONSE_FILE:
+                fprintf(stderr, "ERROR: Unable to read response file %s\n", name);
+                break;
+            case ARG_ERROR_RESPONSE_FILE_DEPTH:
+                fprintf(stderr,
+                        "ERROR: Response files nested too deeply (max depth %d)\n",
+                        ARG_RESPONSE_FILE_MAX_DEPTH);
+                break;
+            case ARG_ERROR_RESPONSE_FILE_SYNTAX:
+                fprintf(stderr, "ERROR: Unterminated quote in response file\n");
+                break;
+            case ARG_ERROR_OUT_OF_MEMORY:
+                fprintf(stderr, "ERROR: Unable to allocate memory for arguments\n");
+                break;
+            case ARG_ERROR_NONE:
+                _ARG_UNREACHABLE();
+        }
+        exit(1);
+    }
+    parser->error.kind = kind;
+    parser->error.idx = idx;
+    size_t name_len = name != NULL ? strlen(name) : 0;
+    if (name_len >= ARG_ERROR_MAX_NAME)
+        name_len = ARG_ERROR_MAX_NAME - 1;
+    if (name_len > 0)
+        memcpy(parser->error.name, name, name_len);
+    parser->error.name[name_len] = '\0';
+    // Stop parsing (any open response files are still released by `free_args`)
+    parser->idx = parser->argc;
+    parser->response_file = NULL;
+    parser->response_depth = 0;
+    parser->classified = false;
+    return false;
+}
+
+/*
+ * Read the next token from the response file, splitting it in place.
+ *
+ * Returns NULL at the end of the file (or on error).
+ */
+static char* _arg_response_next_token(struct arg_parser* parser, struct arg_response_file* file) {
+    char* data = file->data;
+    size_t size = file->size;
+    size_t read = file->offset;
+    while (read < size && (data[read] == '\0' || strchr(" \t\r\n\v\f", data[read]) != NULL)) {
+        read += 1;
+    }
+    if (read >= size) {
+        file->offset = size;
+        return NULL;
+    }
+    // Removing quotes and escapes only ever shrinks the token, so it is written in place
+    char* token = &data[read];
+    size_t write = read;
+    char quote = '\0';
+    while (read < size) {
+        char c = data[read];
+        if (quote == '\0' && (c == '\0' || strchr(" \t\r\n\v\f", c) != NULL)) {
+            break;
+        } else if (c == '\\' && quote != '\'' && read + 1 < size) {
+            data[write++] = data[read + 1];
+            read += 2;
+        } else if (c == quote) {
+            quote = '\0';
+            read += 1;
+        } else if (quote == '\0' && (c == '\'' || c == '"')) {
+            quote = c;
+            read += 1;
+        } else {
+            data[write++] = c;
+            read += 1;
+        }
+    }
+    if (quote != '\0') {
+        _arg_fail(parser, ARG_ERROR_RESPONSE_FILE_SYNTAX, _arg_current_idx(parser), NULL);
+        return NULL;
+    }
+    file->offset = read < size ? read + 1 : size;
+    // Files that aren't mapped always have room for an extra byte at the end
+    if (write < size || !file->mapped) {
+        data[write] = '\0';
+        return token;
+    }
+    // The token ends exactly at the end of a mapped file, so there is no room for a null terminator
+    assert(file->mapped && file->tail_token == NULL);
+    size_t len = write - (size_t)(token - data);
+    file->tail_token = malloc(len + 1);
+    if (file->tail_token == NULL) {
+        _arg_fail(parser, ARG_ERROR_OUT_OF_MEMORY, _arg_current_idx(parser), NULL);
+        return NULL;
+    }
+    memcpy(file->tail_token, token, len);
+    file->tail_token[len] = '\0';
+    return file->tail_token;
+}
+
+#ifdef _ARG_HAVE_MMAP
+typedef int _arg_response_handle;
+#else
+typedef FILE* _arg_response_handle;
+#endif
+
+/*
+ * Read up to `len` bytes, returning zero at the end of the file.
+ *
+ * Sets `failed` if there is an error.
+ */
+static inline size_t _arg_response_read_some(_arg_response_handle handle, char* buf, size_t len, bool* failed) {
+#ifdef _ARG_HAVE_MMAP
+    ssize_t count;
+    do {
+        count = read(handle, buf, len);
+    } while (count < 0 && errno == EINTR);
+    *failed = count < 0;
+    return count > 0 ? (size_t)count : 0;
+#else
+    size_t count = fread(buf, 1, len, handle);
+    *failed = count == 0 && ferror(handle);
+    return count;
+#endif
+}
+
+/*
+ * Read the whole response file into a single buffer.
+ *
+ * This is used when the file can't be mapped into memory (like a pipe).
+ * Returns false on failure.
+ */
+static bool _arg_response_read(struct arg_response_file* file, _arg_response_handle handle) {
+    size_t capacity = 4096;
+    size_t size = 0;
+    char* data = malloc(capacity);
+    while (data != NULL) {
+        bool failed;
+        size_t count = _arg_response_read_some(handle, &data[size], capacity - size, &failed);
+        if (failed) {
+            free(data);
+            return false;
+        } else if (count == 0) {
+            break;
+        }
+        size += count;
+        if (size < capacity)
+            continue;
+        char* grown = realloc(data, capacity * 2);
+        if (grown == NULL)
+            free(data);
+        data = grown;
+        capacity *= 2;
+    }
+    if (data == NULL)
+        return false;
+    // Since size < capacity, there is always room for the final null terminator
+    file->data = data;
+    file->size = size;
+    file->mapped = false;
+    return true;
+}
+
+/*
+ * Open the response file at the specified path, mapping it into memory if possible.
+ *
+ * Returns false on failure.
+ */
+static bool _arg_response_open(struct arg_response_file* file, const char* path) {
+#ifdef _ARG_HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    bool success;
+    if (S_ISREG(info.st_mode) && info.st_size > 0) {
+        // Private mappings are copy-on-write, so tokenizing in place doesn't modify the file
+        void* data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        success = data != MAP_FAILED;
+        if (success) {
+            file->data = data;
+            file->size = (size_t)info.st_size;
+            file->mapped = true;
+        }
+    } else {
+        // Pipes and devices report a size of zero, so they have to be read until the end
+        success = _arg_response_read(file, fd);
+    }
+    close(fd);
+    return success;
+#else
+    FILE* f = fopen(path, "rb");
+    if (f == NULL)
+        return false;
+    bool success = _arg_response_read(file, f);
+    fclose(f);
+    return success;
+#endif
+}
+
+static void _arg_response_close(struct arg_response_file* file) {
+#ifdef _ARG_HAVE_MMAP
+    if (file->mapped && file->data != NULL) {
+        munmap(file->data, file->size);
+    }
+#endif
+    if (!file->mapped) {
+        free(file->data);
+    }
+    free(file->tail_token);
+    free(file);
+}
+
+/*
+ * Find the current argument, expanding any response files.
+ *
+ * This is the slow path of `current_arg`.
+ */
+static char* _arg_current_expanded(struct arg_parser* parser) {
+    while (true) {
+        struct arg_response_file* file = parser->response_file;
+        char* arg;
+        if (file != NULL) {
+            if (file->token == NULL)
+                file->token = _arg_response_next_token(parser, file);
+            if (parser->error.kind != ARG_ERROR_NONE) {
+                return NULL;
+            } else if (file->token == NULL) {
+                // Finished with this file (but keep it open, since its values are still in use)
+                parser->response_file = file->parent;
+                parser->response_depth -= 1;
+                continue;
+            }
+            arg = file->token;
+        } else if (parser->idx < parser->argc) {
+            arg = parser->argv[parser->idx];
+        } else {
+            return NULL;
+        }
+        if (!parser->expand_response_files || arg[0] != '@' || arg[1] == '\0')
+            return arg;
+        int arg_idx = _arg_current_idx(parser);
+        if (parser->response_depth >= ARG_RESPONSE_FILE_MAX_DEPTH) {
+            _arg_fail(parser, ARG_ERROR_RESPONSE_FILE_DEPTH, arg_idx, &arg[1]);
+            return NULL;
+        }
+        struct arg_response_file* nested = calloc(1, sizeof(struct arg_response_file));
+        if (nested == NULL) {
+            _arg_fail(parser, ARG_ERROR_OUT_OF_MEMORY, arg_idx, &arg[1]);
+            return NULL;
+        } else if (!_arg_response_open(nested, &arg[1])) {
+            free(nested);
+            _arg_fail(parser, ARG_ERROR_RESPONSE_FILE, arg_idx, &arg[1]);
+            return NULL;
+        }
+        // Skip over the `@path` argument, then start reading from the file
+        if (file != NULL) {
+            file->token = NULL;
+        } else {
+            parser->idx += 1;
+        }
+        nested->parent = file;
+        nested->previous_opened = parser->last_opened_response_file;
+        parser->last_opened_response_file = nested;
+        parser->response_file = nested;
+        parser->response_depth += 1;
+    }
+}
+
+static inline char* current_arg(struct arg_parser* parser) {
+    if (parser->response_file == NULL && !parser->expand_response_files) {
+        // Fast path: Only arguments from argv
+        return parser->idx < parser->argc ? parser->argv[parser->idx] : NULL;
+    } else {
+        return _arg_current_expanded(parser);
+    }
+}
+
 static inline bool has_args(struct arg_parser* parser) {
-    return parser->idx < parser->argc;
+    return current_arg(parser) != NULL;
 }
 // Forward declaration (because it actually has to do some amount of work)
 static bool has_flag_args(struct arg_parser* parser);
@@ -58,16 +533,75 @@ static inline struct arg_parser init_args(int argc, char* argv[]) {
     return parser;
 }
 static inline char* consume_arg(struct arg_parser* parser) {
-    assert(has_args(parser)); // Bounds check
-    return parser->argv[parser->idx++];
+    char* arg = current_arg(parser);
+    assert(arg != NULL); // Bounds check
+    if (parser->response_file != NULL) {
+        parser->response_file->token = NULL;
+    } else {
+        parser->idx += 1;
+    }
+    parser->classified = false;
+    return arg;
 }
 
-static inline char* current_arg(struct arg_parser* parser) {
-    if (has_args(parser)) {
-        return parser->argv[parser->idx];
+/*
+ * Release any response files opened by the parser.
+ *
+ * Only necessary if `expand_response_files` is enabled.
+ * Any arguments (or values) from the response files are invalid afterwards.
+ */
+static inline void free_args(struct arg_parser* parser) {
+    struct arg_response_file* file = parser->last_opened_response_file;
+    while (file != NULL) {
+        struct arg_response_file* previous = file->previous_opened;
+        _arg_response_close(file);
+        file = previous;
+    }
+    parser->last_opened_response_file = NULL;
+    parser->response_file = NULL;
+    parser->response_depth = 0;
+}
+
+/*
+ * Classify the current argument, reusing the cached result if possible.
+ *
+ * Requires that there are remaining arguments.
+ */
+static inline enum arg_kind _arg_classify(struct arg_parser* parser) {
+    assert(has_args(parser));
+    if (parser->classified)
+        return parser->current_kind;
+    char* arg = current_arg(parser);
+    enum arg_kind kind;
+    parser->current_name_len = 0;
+    parser->current_inline_value = NULL;
+    parser->short_offset = 1;
+    if (arg[0] != '-' || arg[1] == '\0') {
+        // NOTE: We used to give a warning for '-' as a positional arg.
+        // Since neither `cargo pkgid -` or `git rev-parse -` do this
+        // I have decided it is not unix-like and have decided
+        // to unconditionally accept '-' (and the empty string)
+        // as positional arguments
+        kind = ARG_KIND_POSITIONAL;
+    } else if (arg[1] != '-') {
+        // Either a single short flag "-k", or a bundle "-xvf"
+        kind = ARG_KIND_SHORT;
+    } else if (arg[2] == '\0') {
+        // "--" delimits the positional arguments
+        kind = ARG_KIND_SEPARATOR;
     } else {
-        return NULL;
+        // Split "--name=value" in place (without copying)
+        kind = ARG_KIND_LONG;
+        char* name = &arg[2];
+        size_t name_len = strcspn(name, "=");
+        parser->current_name_len = name_len;
+        if (name[name_len] == '=') {
+            parser->current_inline_value = &name[name_len + 1];
+        }
     }
+    parser->classified = true;
+    parser->current_kind = kind;
+    return kind;
 }
 
 static bool has_flag_args(struct arg_parser* parser) {
@@ -75,50 +609,87 @@ static bool has_flag_args(struct arg_parser* parser) {
         return false;
     if (parser->finished_flags)
         return false;
-    char* arg = current_arg(parser);
-    size_t current_arg_len = strlen(arg);
-    switch (current_arg_len) {
-        case 0:
-        case 1:
-            // NOTE: We used to give a warning for '-' as a positional arg.
-            // Since neither `cargo pkgid -` or `git rev-parse -` do this
-            // I have decided it is not unix-like and have decided
-            // to unconditionally accept '-' (and the empty string)
-            // as positional arguments
+    switch (_arg_classify(parser)) {
+        case ARG_KIND_SHORT:
+        case ARG_KIND_LONG:
+            return true;
+        case ARG_KIND_SEPARATOR:
+            consume_arg(parser);
+            goto finished_flags;
+        case ARG_KIND_POSITIONAL:
             goto finished_flags;
-        case 2:
-            // Three cases:
-            // 1. arg == "-k" (short arg)
-            // 2. arg == "--" (delimits the positional arguments)
-            // 3. arg[0] != '-' (it's positional)
-            if (arg[0] == '-') {
-                if (arg[1] == '-') {
-                    // case 2 - "--"
-                    assert(memcmp(arg, "--", 2) == 0);
-                    consume_arg(parser);
-                    goto finished_flags;
-                } else {
-                    // case 1 - short arg
-                    return true;
-                }
-            } else {
-                // case 3 - positional
-                goto finished_flags;
-            }
-        default:
-            assert(current_arg_len >= 2);
-            if (arg[0] == '-') {
-                assert(strcmp(arg, "--") != 0);
-                return true;
-            } else {
-                goto finished_flags;
-            }
     }
+    _ARG_UNREACHABLE();
 finished_flags:
     parser->finished_flags = true;
     return false;
 }
 
+/*
+ * Check if the specified long name matches the current one.
+ *
+ * The current name is not null terminated (it may be followed by `=value`).
+ */
+static inline bool _arg_name_eq(const char* expected, const char* actual, size_t actual_len) {
+    return strncmp(expected, actual, actual_len) == 0 && expected[actual_len] == '\0';
+}
+
+/*
+ * Consume the current flag (which has just been matched) and parse its value.
+ *
+ * Returns false if there was an error (in `return_errors` mode).
+ * Shared between `match_arg` and `match_arg_table`.
+ */
+static bool _arg_take_value(struct arg_parser* parser, const char* full_name, const struct arg_config* config) {
+    char* arg = current_arg(parser);
+    int arg_idx = _arg_current_idx(parser);
+    parser->current_value = NULL;
+    parser->current_value_len = 0;
+    if (parser->current_kind == ARG_KIND_SHORT) {
+        size_t next_offset = parser->short_offset + 1;
+        if (config->flag) {
+            // Move on to the next flag in the bundle (if there is one)
+            if (arg[next_offset] == '\0') {
+                consume_arg(parser);
+            } else {
+                parser->short_offset = next_offset;
+            }
+            return true;
+        }
+        consume_arg(parser);
+        if (arg[next_offset] != '\0') {
+            // The rest of the bundle is the value (like `-ofile`)
+            parser->current_value = &arg[next_offset];
+            parser->current_value_len = strlen(parser->current_value);
+            return true;
+        }
+    } else {
+        assert(parser->current_kind == ARG_KIND_LONG);
+        char* inline_value = parser->current_inline_value;
+        consume_arg(parser);
+        if (inline_value != NULL) {
+            if (config->flag) {
+                return _arg_fail(parser, ARG_ERROR_UNEXPECTED_VALUE, arg_idx, full_name);
+            }
+            parser->current_value = inline_value;
+            parser->current_value_len = strlen(inline_value);
+            return true;
+        } else if (config->flag) {
+            return true;
+        }
+    }
+    // Parse value
+    if (has_args(parser)) {
+        char* value = consume_arg(parser);
+        assert(value != NULL);
+        parser->current_value = value;
+        parser->current_value_len = strlen(value);
+        return true;
+    } else {
+        return _arg_fail(parser, ARG_ERROR_MISSING_VALUE, arg_idx, full_name);
+    }
+}
+
 static const struct arg_config DEFAULT_CONFIG = {0};
 static bool match_arg(struct arg_parser* parser, const char* full_name, const struct arg_config* config) {
     assert(parser != NULL);
@@ -128,73 +699,646 @@ static bool match_arg(struct arg_parser* parser, const char* full_name, const st
     if (config == NULL)
         config = &DEFAULT_CONFIG;
     char* arg = current_arg(parser);
-    size_t len = strlen(arg);
-    switch (len) {
-        case 0:
-        case 1:
-            _ARG_UNREACHABLE(); // Should've been checked in has_flag_args
-        case 2:
-            // Both of these cases should've been cought earlier (in has_flag_args)
-            assert(arg[0] == '-');
-            assert(memcmp(arg, "--", 2) != 0);
-            char actual_short = arg[1];
+    switch (parser->current_kind) {
+        case ARG_KIND_SHORT: {
+            char actual_short = arg[parser->short_offset];
             if (config->short_name != NULL && actual_short == *config->short_name) {
-                consume_arg(parser);
                 goto matched_arg;
             } else {
                 return false; // Some other flag (but not finished yet)
             }
-            _ARG_UNREACHABLE();
-        default:
-            assert(len >= 3);
-            if (memcmp(arg, "--", 2) == 0) {
-                // Good, we have a flag
-                char* actual_name = &arg[2];
-                bool match = strcmp(actual_name, full_name) == 0;
-                const char** aliases = config->aliases;
-                if (aliases != NULL && !match) {
-                    while (*aliases != NULL) {
-                        const char* alias = *aliases;
-                        if (strcmp(alias, actual_name) == 0) {
-                            match = true;
-                            break;
-                        }
-                        aliases += 1;
+        }
+        case ARG_KIND_LONG: {
+            // Good, we have a flag
+            char* actual_name = &arg[2];
+            size_t actual_len = parser->current_name_len;
+            bool match = _arg_name_eq(full_name, actual_name, actual_len);
+            const char** aliases = config->aliases;
+            if (aliases != NULL && !match) {
+                while (*aliases != NULL) {
+                    const char* alias = *aliases;
+                    if (_arg_name_eq(alias, actual_name, actual_len)) {
+                        match = true;
+                        break;
                     }
+                    aliases += 1;
                 }
-                if (match) {
-                    consume_arg(parser);
-                    goto matched_arg;
-                } else {
-                    return false;
-                }
+            }
+            if (match) {
+                goto matched_arg;
             } else {
-                if (arg[0] == '-') {
-                    fprintf(stderr, "Long args must start with --name (not -name)");
-                    fprintf(stderr, "Consider `--` as seperator if this is intended to be a poisitional arg");
-                    exit(1);
-                } else {
-                    // Must be a positional value (which we should've cought earlier)
-                    _ARG_UNREACHABLE();
-                }
+                return false;
             }
+        }
+        case ARG_KIND_POSITIONAL:
+        case ARG_KIND_SEPARATOR:
+            // Should've been handled in has_flag_args
+            _ARG_UNREACHABLE();
     }
     _ARG_UNREACHABLE();
 matched_arg:
-    parser->current_value = NULL;
-    if (config->flag) {
-        return true;
+    return _arg_take_value(parser, full_name, config);
+}
+
+/*
+ * Consume all the remaining arguments at once, as a slice of argv (without copying).
+ *
+ * This is intended for positional arguments (after `has_flag_args` returns false).
+ *
+ * Returns false (consuming nothing) if the remaining arguments aren't contiguous in argv,
+ * which is only possible if `expand_response_files` is enabled.
+ * In that case, use `consume_args_chunk` instead.
+ */
+static inline bool consume_remaining_args(struct arg_parser* parser, char*** args, int* count) {
+    if (parser->response_file != NULL || parser->expand_response_files)
+        return false;
+    int start = parser->idx < parser->argc ? parser->idx : parser->argc;
+    *args = &parser->argv[start];
+    *count = parser->argc - start;
+    parser->idx = parser->argc;
+    parser->classified = false;
+    return true;
+}
+
+/*
+ * Consume up to `capacity` of the remaining arguments, storing them in `buf`.
+ *
+ * Returns the number of arguments consumed (zero once there are no more arguments).
+ * Unlike `consume_remaining_args`, this works with response files.
+ */
+static inline size_t consume_args_chunk(struct arg_parser* parser, char** buf, size_t capacity) {
+    if (parser->response_file == NULL && !parser->expand_response_files) {
+        // Fast path: Copy directly from argv
+        size_t remaining = parser->idx < parser->argc ? (size_t)(parser->argc - parser->idx) : 0;
+        size_t len = remaining < capacity ? remaining : capacity;
+        if (len > 0) {
+            memcpy(buf, &parser->argv[parser->idx], len * sizeof(char*));
+            parser->idx += (int)len;
+            parser->classified = false;
+        }
+        return len;
     }
-    // Parse value
-    if (has_args(parser)) {
-        char* value = consume_arg(parser);
-        assert(value != NULL);
-        parser->current_value = value;
-        return true;
-    } else {
-        fprintf(stderr, "ERROR: Expected a value for --%s\n", full_name);
+    size_t len = 0;
+    while (len < capacity && has_args(parser)) {
+        buf[len++] = consume_arg(parser);
+    }
+    return len;
+}
+
+/*
+ * Parsing integer values
+ *
+ * Unlike strtol/atoi, these are not locale sensitive
+ * and report overflow instead of clamping (or wrapping) the result.
+ *
+ * Values are plain decimal digits with an optional sign (ex: `-17`, `+42`).
+ * There is no support for leading/trailing whitespace.
+ */
+enum arg_value_status {
+    ARG_VALUE_OK = 0,
+    // The value is not a valid integer
+    ARG_VALUE_INVALID,
+    // The value is a valid integer, but doesn't fit in the requested type
+    ARG_VALUE_OVERFLOW,
+};
+
+/*
+ * Allow a binary size suffix after the digits.
+ *
+ * The suffix is a single character: k/K (2^10), M (2^20), G (2^30) or T (2^40).
+ * For example `16k` is parsed as 16384.
+ */
+#define ARG_INT_SIZE_SUFFIX 1u
+
+/*
+ * Parse the size suffix at the end of `value` (if allowed by `flags`).
+ *
+ * Returns the suffix shift (or zero if there is no suffix),
+ * removing the suffix from `len`.
+ */
+static inline int _arg_parse_size_suffix(const char* value, size_t* len, unsigned flags) {
+    if (*len == 0 || (flags & ARG_INT_SIZE_SUFFIX) == 0)
+        return 0;
+    int shift;
+    switch (value[*len - 1]) {
+        case 'k':
+        case 'K':
+            shift = 10;
+            break;
+        case 'M':
+            shift = 20;
+            break;
+        case 'G':
+            shift = 30;
+            break;
+        case 'T':
+            shift = 40;
+            break;
+        default:
+            return 0;
+    }
+    *len -= 1;
+    return shift;
+}
+
+/*
+ * Parse a (signed) 64-bit integer value of the specified length.
+ *
+ * On error, `res` is left unchanged.
+ */
+static enum arg_value_status parse_int64_value(const char* value, size_t len, unsigned flags, int64_t* res) {
+    assert(value != NULL);
+    int shift = _arg_parse_size_suffix(value, &len, flags);
+    bool negative = false;
+    if (len > 0 && (value[0] == '-' || value[0] == '+')) {
+        negative = value[0] == '-';
+        value += 1;
+        len -= 1;
+    }
+    bool invalid = len == 0;
+    bool overflowing = false;
+    int64_t acc = 0;
+    /*
+     * Accumulate with the sign already applied, so that INT64_MIN can be parsed.
+     *
+     * Errors are sticky (instead of returning early), which keeps branches out of the loop.
+     */
+    for (size_t i = 0; i < len; i++) {
+        uint32_t digit = (uint32_t)(unsigned char)value[i] - '0';
+        invalid |= digit > 9;
+        int64_t signed_digit = negative ? -(int64_t)digit : (int64_t)digit;
+        overflowing |= plain_int_overflowing_mul64s(acc, 10, &acc);
+        overflowing |= plain_int_overflowing_add64s(acc, signed_digit, &acc);
+    }
+    if (shift > 0) {
+        overflowing |= plain_int_overflowing_mul64s(acc, ((int64_t)1) << shift, &acc);
+    }
+    if (invalid) {
+        return ARG_VALUE_INVALID;
+    } else if (overflowing) {
+        return ARG_VALUE_OVERFLOW;
+    }
+    *res = acc;
+    return ARG_VALUE_OK;
+}
+
+/*
+ * Parse an unsigned 64-bit integer value of the specified length.
+ *
+ * Negative values are invalid (although a leading `+` is allowed).
+ * On error, `res` is left unchanged.
+ */
+static enum arg_value_status parse_uint64_value(const char* value, size_t len, unsigned flags, uint64_t* res) {
+    assert(value != NULL);
+    int shift = _arg_parse_size_suffix(value, &len, flags);
+    if (len > 0 && value[0] == '+') {
+        value += 1;
+        len -= 1;
+    }
+    bool invalid = len == 0;
+    bool overflowing = false;
+    uint64_t acc = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint32_t digit = (uint32_t)(unsigned char)value[i] - '0';
+        invalid |= digit > 9;
+        // Unsigned arithmetic wraps, so overflow is checked before multiplying
+        overflowing |= (acc > UINT64_MAX / 10) | ((acc == UINT64_MAX / 10) & (digit > UINT64_MAX % 10));
+        acc = acc * 10 + digit;
+    }
+    if (shift > 0) {
+        overflowing |= acc > (UINT64_MAX >> shift);
+        acc <<= shift;
+    }
+    if (invalid) {
+        return ARG_VALUE_INVALID;
+    } else if (overflowing) {
+        return ARG_VALUE_OVERFLOW;
+    }
+    *res = acc;
+    return ARG_VALUE_OK;
+}
+
+/*
+ * Parse a (signed) 32-bit integer value of the specified length.
+ *
+ * On error, `res` is left unchanged.
+ */
+static inline enum arg_value_status parse_int32_value(const char* value, size_t len, unsigned flags, int32_t* res) {
+    int64_t wide;
+    enum arg_value_status status = parse_int64_value(value, len, flags, &wide);
+    if (status != ARG_VALUE_OK)
+        return status;
+    if (wide < INT32_MIN || wide > INT32_MAX)
+        return ARG_VALUE_OVERFLOW;
+    *res = (int32_t)wide;
+    return ARG_VALUE_OK;
+}
+
+/*
+ * Parse the value of the last matched argument as an integer.
+ *
+ * The argument must not be a flag (there must be a value).
+ */
+static inline enum arg_value_status current_value_int32(struct arg_parser* parser, unsigned flags, int32_t* res) {
+    assert(parser->current_value != NULL);
+    return parse_int32_value(parser->current_value, parser->current_value_len, flags, res);
+}
+static inline enum arg_value_status current_value_int64(struct arg_parser* parser, unsigned flags, int64_t* res) {
+    assert(parser->current_value != NULL);
+    return parse_int64_value(parser->current_value, parser->current_value_len, flags, res);
+}
+static inline enum arg_value_status current_value_uint64(struct arg_parser* parser, unsigned flags, uint64_t* res) {
+    assert(parser->current_value != NULL);
+    return parse_uint64_value(parser->current_value, parser->current_value_len, flags, res);
+}
+
+/*
+ * Subcommands (like `git commit`)
+ *
+ * The subcommand is the first positional argument (after the global flags).
+ * It is resolved with a binary search of a sorted table,
+ * so this stays fast with hundreds of subcommands.
+ */
+struct arg_subcommand {
+    // The name of this subcommand
+    const char* name;
+};
+
+// Returned by match_subcommand when there are no positional arguments left
+#define ARG_SUBCOMMAND_MISSING (-1)
+// Returned by match_subcommand when the subcommand is not in the table
+#define ARG_SUBCOMMAND_UNKNOWN (-2)
+// Returned by match_subcommand when the argument is a prefix of multiple subcommands
+#define ARG_SUBCOMMAND_AMBIGUOUS (-3)
+// Returned by match_subcommand when there are flags before the subcommand that haven't been parsed
+#define ARG_SUBCOMMAND_UNPARSED_FLAGS (-4)
+
+static inline bool _arg_has_prefix(const char* s, const char* prefix, size_t prefix_len) {
+    return strncmp(s, prefix, prefix_len) == 0;
+}
+
+/*
+ * Resolve the subcommand named by the current (positional) argument.
+ *
+ * The subcommands must be sorted by name (in `strcmp` order).
+ * If `allow_prefix` is true, an unambiguous prefix of a name also matches (`com` for `commit`).
+ *
+ * On success, this consumes the subcommand, and returns its index in the table.
+ * The `child` parser is positioned at the remaining arguments (so it can parse the subcommand's flags),
+ * and takes ownership of any open response files (so call `free_args` on the child, not the parent).
+ *
+ * On failure, returns one of ARG_SUBCOMMAND_MISSING/UNKNOWN/AMBIGUOUS/UNPARSED_FLAGS
+ * without consuming anything (so `current_arg` can be used to report it).
+ * The global flags must be parsed first, otherwise this gives ARG_SUBCOMMAND_UNPARSED_FLAGS.
+ */
+static inline int match_subcommand(struct arg_parser* parser,
+                                   const struct arg_subcommand* subcommands,
+                                   int num_subcommands,
+                                   bool allow_prefix,
+                                   struct arg_parser* child) {
+    assert(parser != NULL && child != NULL);
+    assert(subcommands != NULL || num_subcommands == 0);
+#ifndef NDEBUG
+    for (int i = 1; i < num_subcommands; i++) {
+        assert(strcmp(subcommands[i - 1].name, subcommands[i].name) < 0 && "Subcommands must be sorted");
+    }
+#endif
+    if (has_flag_args(parser))
+        return ARG_SUBCOMMAND_UNPARSED_FLAGS;
+    char* name = current_arg(parser);
+    if (name == NULL)
+        return ARG_SUBCOMMAND_MISSING;
+    // Binary search for the first subcommand >= name
+    int low = 0;
+    int high = num_subcommands;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strcmp(subcommands[mid].name, name) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low >= num_subcommands)
+        return ARG_SUBCOMMAND_UNKNOWN;
+    const char* found = subcommands[low].name;
+    if (strcmp(found, name) != 0) {
+        // Every name with this prefix sorts immediately after it
+        size_t name_len = strlen(name);
+        // The empty string is a prefix of everything, but shouldn't match anything
+        if (!allow_prefix || name_len == 0 || !_arg_has_prefix(found, name, name_len)) {
+            return ARG_SUBCOMMAND_UNKNOWN;
+        } else if (low + 1 < num_subcommands && _arg_has_prefix(subcommands[low + 1].name, name, name_len)) {
+            return ARG_SUBCOMMAND_AMBIGUOUS;
+        }
+    }
+    consume_arg(parser);
+    // The child takes over the rest of the arguments (and any response files)
+    *child = *parser;
+    child->finished_flags = false;
+    child->classified = false;
+    child->current_value = NULL;
+    child->current_value_len = 0;
+    parser->idx = parser->argc;
+    parser->response_file = NULL;
+    parser->last_opened_response_file = NULL;
+    parser->response_depth = 0;
+    parser->classified = false;
+    return low;
+}
+
+/*
+ * A table of argument configurations, matched in a single pass over argv.
+ *
+ * Chaining one `match_arg` per option costs O(options) string comparisons
+ * for every token. Instead, the table indexes short names directly
+ * and long names (plus their aliases) with a perfect hash,
+ * so each token is dispatched to its option index in constant time.
+ *
+ * Every config in the table must have a `full_name`.
+ *
+ * Usage:
+ *    struct arg_table table = init_arg_table(CONFIGS, NUM_CONFIGS);
+ *    int idx;
+ *    while ((idx = match_arg_table(&parser, &table)) != ARG_TABLE_FINISHED) {
+ *        switch (idx) { ... }
+ *    }
+ *    free_arg_table(&table);
+ */
+struct arg_table_slot {
+    // The long name (or alias) for this slot, NULL if the slot is empty
+    const char* name;
+    size_t name_len;
+    int config_idx;
+};
+struct arg_table {
+    const struct arg_config* configs;
+    int num_configs;
+    // Index of the config with the specified short name, plus one (zero if none)
+    int short_index[256];
+    /*
+     * Perfect hash of long names (and aliases).
+     *
+     * The name's hash selects a bucket, and the bucket's displacement
+     * selects the final slot. The displacements are chosen in init_arg_table
+     * so that no two names share a slot, so a lookup never has to probe.
+     */
+    struct arg_table_slot* slots;
+    uint32_t* displacements;
+    size_t slot_mask;
+    size_t bucket_mask;
+};
+
+// Returned by match_arg_table when there are no more flag arguments
+#define ARG_TABLE_FINISHED (-1)
+// Returned by match_arg_table when the current flag is not in the table
+//
+// The flag is not consumed, so `current_arg` can be used to report it.
+#define ARG_TABLE_UNKNOWN (-2)
+// Returned by match_arg_table when there is an error (only in `return_errors` mode)
+//
+// Like ARG_TABLE_FINISHED, this is returned for every call after the error.
+#define ARG_TABLE_ERROR (-3)
+
+/*
+ * Hash a long argument name (FNV-1a).
+ */
+static inline uint64_t _arg_hash_name(const char* name, size_t len) {
+    uint64_t hash = 14695981039346656037u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)name[i];
+        hash *= 1099511628211u;
+    }
+    return hash;
+}
+
+/*
+ * Select the slot for a hash, given the displacement of its bucket.
+ *
+ * This is the finalizer from MurmurHash3,
+ * so every displacement gives an independent-looking permutation of the slots.
+ */
+static inline size_t _arg_hash_slot(uint64_t hash, uint32_t displacement) {
+    uint64_t h = hash ^ (displacement * 0x9E3779B97F4A7C15u);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDu;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53u;
+    h ^= h >> 33;
+    return (size_t)h;
+}
+
+// Give up on the perfect hash after this many displacements for a single bucket
+#define _ARG_TABLE_MAX_DISPLACEMENT 0x100000u
+
+struct _arg_table_key {
+    const char* name;
+    size_t name_len;
+    uint64_t hash;
+    int config_idx;
+    // Next key in the same bucket (or -1)
+    int next;
+};
+
+static inline void* _arg_table_alloc(size_t count, size_t size) {
+    void* res = calloc(count, size);
+    if (res == NULL) {
+        fprintf(stderr, "ERROR: Unable to allocate argument table\n");
         exit(1);
     }
+    return res;
+}
+
+/*
+ * Duplicate names are a bug in the program (not the arguments), so this always exits.
+ *
+ * This is checked even with NDEBUG, since a duplicate short name would silently replace the earlier one,
+ * and a duplicate long name makes the perfect hash impossible to build.
+ */
+static inline void _arg_table_duplicate_name(const char* prefix, const char* name) {
+    fprintf(stderr, "ERROR: Duplicate argument name %s%s in argument table\n", prefix, name);
+    exit(1);
+}
+
+/*
+ * Try and place every key in the bucket at the specified displacement.
+ *
+ * Returns false (without modifying the slots) if any of them collide.
+ */
+static inline bool _arg_table_try_place(struct arg_table* table,
+                                        const struct _arg_table_key* keys,
+                                        int bucket_head,
+                                        uint32_t displacement) {
+    for (int i = bucket_head; i >= 0; i = keys[i].next) {
+        size_t slot = _arg_hash_slot(keys[i].hash, displacement) & table->slot_mask;
+        if (table->slots[slot].name != NULL)
+            return false;
+        // Two keys in the same bucket could collide with each other
+        for (int j = bucket_head; j != i; j = keys[j].next) {
+            if ((_arg_hash_slot(keys[j].hash, displacement) & table->slot_mask) == slot)
+                return false;
+        }
+    }
+    for (int i = bucket_head; i >= 0; i = keys[i].next) {
+        struct arg_table_slot* slot = &table->slots[_arg_hash_slot(keys[i].hash, displacement) & table->slot_mask];
+        slot->name = keys[i].name;
+        slot->name_len = keys[i].name_len;
+        slot->config_idx = keys[i].config_idx;
+    }
+    return true;
+}
+
+static inline struct arg_table init_arg_table(const struct arg_config* configs, int num_configs) {
+    assert(configs != NULL || num_configs == 0);
+    struct arg_table table = {.configs = configs, .num_configs = num_configs};
+    size_t num_names = 0;
+    for (int i = 0; i < num_configs; i++) {
+        const struct arg_config* config = &configs[i];
+        assert(config->full_name != NULL);
+        num_names += 1;
+        if (config->aliases != NULL) {
+            for (const char** alias = config->aliases; *alias != NULL; alias++) {
+                num_names += 1;
+            }
+        }
+        if (config->short_name != NULL) {
+            unsigned char short_name = (unsigned char)*config->short_name;
+            if (table.short_index[short_name] != 0)
+                _arg_table_duplicate_name("-", config->short_name);
+            table.short_index[short_name] = i + 1;
+        }
+    }
+    /*
+     * This is the "hash, displace, and compress" algorithm (without the compression).
+     *
+     * Keys are grouped into small buckets (averaging two keys each),
+     * then the biggest buckets are placed first (while the table is still mostly empty).
+     * Keeping the load factor at or below 1/2 means a working displacement is found quickly.
+     */
+    size_t num_slots = 8;
+    while (num_slots < num_names * 2) {
+        num_slots *= 2;
+    }
+    size_t num_buckets = 1;
+    while (num_buckets * 2 < num_names) {
+        num_buckets *= 2;
+    }
+    table.slots = _arg_table_alloc(num_slots, sizeof(struct arg_table_slot));
+    table.displacements = _arg_table_alloc(num_buckets, sizeof(uint32_t));
+    table.slot_mask = num_slots - 1;
+    table.bucket_mask = num_buckets - 1;
+    // Temporary storage, only needed until the displacements are computed
+    struct _arg_table_key* keys = _arg_table_alloc(num_names + 1, sizeof(struct _arg_table_key));
+    int* bucket_heads = _arg_table_alloc(num_buckets, sizeof(int));
+    size_t* bucket_sizes = _arg_table_alloc(num_buckets, sizeof(size_t));
+    size_t max_bucket_size = 0;
+    for (size_t bucket = 0; bucket < num_buckets; bucket++) {
+        bucket_heads[bucket] = -1;
+    }
+    size_t key_idx = 0;
+    for (int i = 0; i < num_configs; i++) {
+        const struct arg_config* config = &configs[i];
+        const char** aliases = config->aliases;
+        const char* name = config->full_name;
+        while (name != NULL) {
+            struct _arg_table_key* key = &keys[key_idx];
+            key->name = name;
+            key->name_len = strlen(name);
+            key->hash = _arg_hash_name(name, key->name_len);
+            key->config_idx = i;
+            size_t bucket = key->hash & table.bucket_mask;
+            // Identical names would always collide, so they need to be rejected up front
+            for (int j = bucket_heads[bucket]; j >= 0; j = keys[j].next) {
+                if (keys[j].name_len == key->name_len && memcmp(keys[j].name, name, key->name_len) == 0)
+                    _arg_table_duplicate_name("--", name);
+            }
+            key->next = bucket_heads[bucket];
+            bucket_heads[bucket] = (int)key_idx;
+            bucket_sizes[bucket] += 1;
+            if (bucket_sizes[bucket] > max_bucket_size)
+                max_bucket_size = bucket_sizes[bucket];
+            key_idx += 1;
+            name = (aliases != NULL) ? *aliases++ : NULL;
+        }
+    }
+    assert(key_idx == num_names);
+    // Place the buckets in order of decreasing size
+    for (size_t size = max_bucket_size; size > 0; size--) {
+        for (size_t bucket = 0; bucket < num_buckets; bucket++) {
+            if (bucket_sizes[bucket] != size)
+                continue;
+            uint32_t displacement = 0;
+            while (!_arg_table_try_place(&table, keys, bucket_heads[bucket], displacement)) {
+                displacement += 1;
+                if (displacement >= _ARG_TABLE_MAX_DISPLACEMENT) {
+                    fprintf(stderr, "ERROR: Unable to build a perfect hash for the argument table\n");
+                    exit(1);
+                }
+            }
+            table.displacements[bucket] = displacement;
+        }
+    }
+    free(keys);
+    free(bucket_heads);
+    free(bucket_sizes);
+    return table;
+}
+
+static inline void free_arg_table(struct arg_table* table) {
+    free(table->slots);
+    free(table->displacements);
+    table->slots = NULL;
+    table->displacements = NULL;
+    table->slot_mask = 0;
+    table->bucket_mask = 0;
+}
+
+/*
+ * Find the config for the specified long name.
+ *
+ * This costs one hash and (at most) one comparison, regardless of table size.
+ */
+static inline int _arg_table_find_long(const struct arg_table* table, const char* name, size_t len) {
+    uint64_t hash = _arg_hash_name(name, len);
+    uint32_t displacement = table->displacements[hash & table->bucket_mask];
+    const struct arg_table_slot* entry = &table->slots[_arg_hash_slot(hash, displacement) & table->slot_mask];
+    if (entry->name != NULL && entry->name_len == len && memcmp(entry->name, name, len) == 0) {
+        return entry->config_idx;
+    } else {
+        return ARG_TABLE_UNKNOWN;
+    }
+}
+
+/*
+ * Match the current argument against every config in the table.
+ *
+ * Returns the index of the matched config (setting `current_value` like `match_arg`),
+ * ARG_TABLE_FINISHED if there are no more flags,
+ * ARG_TABLE_UNKNOWN if the current flag is not in the table,
+ * or ARG_TABLE_ERROR if there was an error (in `return_errors` mode).
+ */
+static inline int match_arg_table(struct arg_parser* parser, const struct arg_table* table) {
+    assert(parser != NULL);
+    assert(table != NULL && table->slots != NULL);
+    if (!has_flag_args(parser))
+        return parser->error.kind != ARG_ERROR_NONE ? ARG_TABLE_ERROR : ARG_TABLE_FINISHED;
+    char* arg = current_arg(parser);
+    int config_idx;
+    // has_flag_args has already handled positional arguments and "--"
+    if (parser->current_kind == ARG_KIND_SHORT) {
+        config_idx = table->short_index[(unsigned char)arg[parser->short_offset]] - 1;
+    } else {
+        assert(parser->current_kind == ARG_KIND_LONG);
+        config_idx = _arg_table_find_long(table, &arg[2], parser->current_name_len);
+    }
+    if (config_idx < 0)
+        return ARG_TABLE_UNKNOWN;
+    assert(config_idx < table->num_configs);
+    const struct arg_config* config = &table->configs[config_idx];
+    if (!_arg_take_value(parser, config->full_name, config))
+        return ARG_TABLE_ERROR;
+    return config_idx;
 }
 
 #undef _ARG_UNREACHABLE // Macro hygine
+#undef _ARG_TABLE_MAX_DISPLACEMENT
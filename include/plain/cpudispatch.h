@@ -0,0 +1,320 @@
+/**
+ * Runtime detection of x86 CPU features, for choosing the fastest implementation at runtime.
+ *
+ * Requires "intbuiltins.h"
+ *
+ * Without compiler flags like `-mlzcnt` or `-mpopcnt`, GCC and Clang have to assume
+ * the baseline x86-64 instruction set. So `__builtin_clz` compiles to `bsr` plus fixups,
+ * and `__builtin_popcount` becomes a call to a library function.
+ * Raising the baseline isn't an option if the same binary has to run on older CPUs.
+ *
+ * This header checks the CPU features once (using cpuid) and caches the result.
+ * The PLAIN_CPU_HAS_* macros are compile-time constants whenever the feature is already
+ * enabled by the compiler flags, so dispatching on them has zero cost in that case.
+ *
+ * For example:
+ *     PLAIN_CPU_TARGET("popcnt") static size_t count_bits_popcnt(const uint64_t *bits, size_t n);
+ *     static size_t count_bits_baseline(const uint64_t *bits, size_t n);
+ *
+ *     size_t count_bits(const uint64_t *bits, size_t n) {
+ *         if (PLAIN_CPU_HAS_POPCNT()) return count_bits_popcnt(bits, n);
+ *         return count_bits_baseline(bits, n);
+ *     }
+ *
+ * Checking the (cached) features is a load and a predictable branch.
+ * Functions compiled for a different target can't be inlined into their callers,
+ * so dispatch around whole loops where possible (like intvec.h does with PLAINLIBS_INTVEC_DISPATCH).
+ *
+ * On other architectures, every feature is reported as missing.
+ *
+ * Dual-licensed under Creative Commons CC0 (Public Domain) and the MIT License.
+ *
+ * Source code & issue tracker: https://github.com/Techcable/plainlibs
+ *
+ * VERSION: 0.1.0-beta.3-dev
+ *
+ * CHANGELOG:
+ *
+ * NEXT:
+ * - Initial release
+ */
+#ifndef PLAINLIBS_CPUDISPATCH_H
+#define PLAINLIBS_CPUDISPATCH_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "plain/intbuiltins.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define _PLAIN_CPU_X86_GNU
+#include <cpuid.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define _PLAIN_CPU_X86_MSVC
+#include <intrin.h>
+#endif
+
+/*
+ * Feature flags, as returned by plain_cpu_features()
+ */
+#define PLAIN_CPU_LZCNT (1u << 0)
+#define PLAIN_CPU_POPCNT (1u << 1)
+#define PLAIN_CPU_BMI1 (1u << 2)
+#define PLAIN_CPU_BMI2 (1u << 3)
+#define PLAIN_CPU_AVX2 (1u << 4)
+// Set once the features have been detected (so the cache is never zero)
+#define _PLAIN_CPU_DETECTED (1u << 31)
+
+/**
+ * Marks a function as compiled for the specified features (for example `"lzcnt,popcnt"`).
+ *
+ * This is only needed for GCC & Clang. MSVC allows using intrinsics for any instruction set,
+ * so this expands to nothing there.
+ */
+#if defined(_PLAIN_CPU_X86_GNU)
+#define PLAIN_CPU_TARGET(features) __attribute__((target(features)))
+#else
+#define PLAIN_CPU_TARGET(features)
+#endif
+
+#if defined(_PLAIN_CPU_X86_GNU) || defined(_PLAIN_CPU_X86_MSVC)
+static inline void _plain_cpu_cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_PLAIN_CPU_X86_GNU)
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    regs[0] = a;
+    regs[1] = b;
+    regs[2] = c;
+    regs[3] = d;
+#else
+    int info[4];
+    __cpuidex(info, (int)leaf, (int)subleaf);
+    for (int i = 0; i < 4; i++) {
+        regs[i] = (uint32_t)info[i];
+    }
+#endif
+}
+
+/**
+ * Read the XCR0 register, which says which register state the OS saves on context switches.
+ *
+ * Only valid if cpuid reports OSXSAVE.
+ */
+static inline uint64_t _plain_cpu_xcr0(void) {
+#if defined(_PLAIN_CPU_X86_GNU)
+    // The xgetbv intrinsic requires -mxsave, so use inline assembly
+    uint32_t low, high;
+    __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((uint64_t)high << 32) | low;
+#else
+    return _xgetbv(0);
+#endif
+}
+#endif
+
+/**
+ * Detect the features of the current CPU, without caching.
+ *
+ * Returns a bitmask of the PLAIN_CPU_* flags.
+ * Prefer plain_cpu_features, which only does this once.
+ */
+static inline unsigned plain_cpu_detect_features(void) {
+    unsigned features = 0;
+#if defined(_PLAIN_CPU_X86_GNU) || defined(_PLAIN_CPU_X86_MSVC)
+    uint32_t regs[4];
+    _plain_cpu_cpuid(0, 0, regs);
+    uint32_t max_leaf = regs[0];
+    _plain_cpu_cpuid(1, 0, regs);
+    uint32_t leaf1_ecx = regs[2];
+    if (leaf1_ecx & (1u << 23)) features |= PLAIN_CPU_POPCNT;
+    // AVX needs support from both the CPU and the OS (saving the YMM registers)
+    bool os_avx = (leaf1_ecx & (1u << 27)) && (leaf1_ecx & (1u << 28)) && (_plain_cpu_xcr0() & 6) == 6;
+    if (max_leaf >= 7) {
+        _plain_cpu_cpuid(7, 0, regs);
+        uint32_t leaf7_ebx = regs[1];
+        if (leaf7_ebx & (1u << 3)) features |= PLAIN_CPU_BMI1;
+        if ((leaf7_ebx & (1u << 5)) && os_avx) features |= PLAIN_CPU_AVX2;
+        if (leaf7_ebx & (1u << 8)) features |= PLAIN_CPU_BMI2;
+    }
+    // LZCNT is an extended feature (AMD called it ABM)
+    _plain_cpu_cpuid(0x80000000u, 0, regs);
+    if (regs[0] >= 0x80000001u) {
+        _plain_cpu_cpuid(0x80000001u, 0, regs);
+        if (regs[2] & (1u << 5)) features |= PLAIN_CPU_LZCNT;
+    }
+#endif
+    return features;
+}
+
+/**
+ * The features of the current CPU, as a bitmask of the PLAIN_CPU_* flags.
+ *
+ * The first call detects the features, and later calls return the cached result.
+ * The cache is per translation unit (since this is header only).
+ * It is safe to call from multiple threads, they would all detect the same features.
+ */
+static inline unsigned plain_cpu_features(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    static unsigned cached = 0;
+    unsigned features = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if (features == 0) {
+        features = plain_cpu_detect_features() | _PLAIN_CPU_DETECTED;
+        __atomic_store_n(&cached, features, __ATOMIC_RELAXED);
+    }
+#else
+    // MSVC doesn't tear aligned loads/stores of volatile ints
+    static volatile unsigned cached = 0;
+    unsigned features = cached;
+    if (features == 0) {
+        features = plain_cpu_detect_features() | _PLAIN_CPU_DETECTED;
+        cached = features;
+    }
+#endif
+    return features & ~_PLAIN_CPU_DETECTED;
+}
+
+/*
+ * Check if the current CPU has a feature.
+ *
+ * These are the constant `true` if the compiler flags already enable the feature.
+ * MSVC doesn't have separate flags, but /arch:AVX implies POPCNT and /arch:AVX2 implies the rest.
+ */
+#define _PLAIN_CPU_HAS_RUNTIME(flag) ((plain_cpu_features() & (flag)) != 0)
+
+#if defined(__LZCNT__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define PLAIN_CPU_HAS_LZCNT() true
+#else
+#define PLAIN_CPU_HAS_LZCNT() _PLAIN_CPU_HAS_RUNTIME(PLAIN_CPU_LZCNT)
+#endif
+
+#if defined(__POPCNT__) || (defined(_MSC_VER) && defined(__AVX__))
+#define PLAIN_CPU_HAS_POPCNT() true
+#else
+#define PLAIN_CPU_HAS_POPCNT() _PLAIN_CPU_HAS_RUNTIME(PLAIN_CPU_POPCNT)
+#endif
+
+#if defined(__BMI__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define PLAIN_CPU_HAS_BMI1() true
+#else
+#define PLAIN_CPU_HAS_BMI1() _PLAIN_CPU_HAS_RUNTIME(PLAIN_CPU_BMI1)
+#endif
+
+#if defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define PLAIN_CPU_HAS_BMI2() true
+#else
+#define PLAIN_CPU_HAS_BMI2() _PLAIN_CPU_HAS_RUNTIME(PLAIN_CPU_BMI2)
+#endif
+
+#if defined(__AVX2__)
+#define PLAIN_CPU_HAS_AVX2() true
+#else
+#define PLAIN_CPU_HAS_AVX2() _PLAIN_CPU_HAS_RUNTIME(PLAIN_CPU_AVX2)
+#endif
+
+/*
+ * Dispatching versions of the intbuiltins.h bit counting functions.
+ *
+ * These only dispatch if the instruction isn't already enabled at compile time,
+ * and the builtins/intrinsics are being used (not the portable fallbacks).
+ * Otherwise, they are exactly the same as the plain_int_* functions.
+ *
+ * Prefer dispatching around a whole loop, since the target specific versions can't be inlined.
+ */
+#if defined(_PLAIN_CPU_X86_GNU) && defined(_PLAIN_INT_GNU_BUILTINS)
+#if !defined(__LZCNT__)
+#define _PLAIN_CPU_DISPATCH_LZCNT
+PLAIN_CPU_TARGET("lzcnt") static inline int _plain_int_nlz32_lzcnt(uint32_t val) {
+    return __builtin_clz(val);
+}
+PLAIN_CPU_TARGET("lzcnt") static inline int _plain_int_nlz64_lzcnt(uint64_t val) {
+    return __builtin_clzll((unsigned long long)val);
+}
+#endif
+#if !defined(__POPCNT__)
+#define _PLAIN_CPU_DISPATCH_POPCNT
+PLAIN_CPU_TARGET("popcnt") static inline int _plain_int_popcount32_popcnt(uint32_t val) {
+    return __builtin_popcount(val);
+}
+PLAIN_CPU_TARGET("popcnt") static inline int _plain_int_popcount64_popcnt(uint64_t val) {
+    return __builtin_popcountll((unsigned long long)val);
+}
+#endif
+#elif defined(_PLAIN_CPU_X86_MSVC) && defined(_PLAIN_INT_MSVC_INTRINSICS)
+// MSVC allows the intrinsics without any flags
+#if !defined(__AVX2__)
+#define _PLAIN_CPU_DISPATCH_LZCNT
+static inline int _plain_int_nlz32_lzcnt(uint32_t val) {
+    return (int)__lzcnt(val);
+}
+static inline int _plain_int_nlz64_lzcnt(uint64_t val) {
+#if defined(_M_X64)
+    return (int)__lzcnt64(val);
+#else
+    uint32_t high = (uint32_t)(val >> 32);
+    return high != 0 ? (int)__lzcnt(high) : 32 + (int)__lzcnt((uint32_t)val);
+#endif
+}
+#endif
+#if !defined(__AVX__)
+#define _PLAIN_CPU_DISPATCH_POPCNT
+static inline int _plain_int_popcount32_popcnt(uint32_t val) {
+    return (int)__popcnt(val);
+}
+static inline int _plain_int_popcount64_popcnt(uint64_t val) {
+#if defined(_M_X64)
+    return (int)__popcnt64(val);
+#else
+    return (int)(__popcnt((uint32_t)val) + __popcnt((uint32_t)(val >> 32)));
+#endif
+}
+#endif
+#endif
+
+/**
+ * Count the number of leading zeros, using LZCNT if the CPU supports it.
+ *
+ * Undefined behavior if the specified value is zero (just like plain_int_nlz32).
+ */
+static inline int plain_int_nlz32_dispatch(uint32_t val) {
+#if defined(_PLAIN_CPU_DISPATCH_LZCNT)
+    assert(val != 0);
+    if (PLAIN_CPU_HAS_LZCNT()) return _plain_int_nlz32_lzcnt(val);
+#endif
+    return plain_int_nlz32(val);
+}
+
+/**
+ * Count the number of leading zeros, using LZCNT if the CPU supports it.
+ *
+ * Undefined behavior if the specified value is zero (just like plain_int_nlz64).
+ */
+static inline int plain_int_nlz64_dispatch(uint64_t val) {
+#if defined(_PLAIN_CPU_DISPATCH_LZCNT)
+    assert(val != 0);
+    if (PLAIN_CPU_HAS_LZCNT()) return _plain_int_nlz64_lzcnt(val);
+#endif
+    return plain_int_nlz64(val);
+}
+
+/**
+ * Count the number of one bits, using POPCNT if the CPU supports it.
+ */
+static inline int plain_int_popcount32_dispatch(uint32_t val) {
+#if defined(_PLAIN_CPU_DISPATCH_POPCNT)
+    if (PLAIN_CPU_HAS_POPCNT()) return _plain_int_popcount32_popcnt(val);
+#endif
+    return plain_int_popcount32(val);
+}
+
+/**
+ * Count the number of one bits, using POPCNT if the CPU supports it.
+ */
+static inline int plain_int_popcount64_dispatch(uint64_t val) {
+#if defined(_PLAIN_CPU_DISPATCH_POPCNT)
+    if (PLAIN_CPU_HAS_POPCNT()) return _plain_int_popcount64_popcnt(val);
+#endif
+    return plain_int_popcount64(val);
+}
+
+#endif /* PLAINLIBS_CPUDISPATCH_H */
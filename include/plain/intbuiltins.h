@@ -24,6 +24,20 @@
  *
  * NEXT:
  * - Initial release
+ * - Added branchless and de Bruijn fallbacks for nlz (selected by `PLAINLIBS_NLZ_FALLBACK`)
+ * - Use MSVC intrinsics for nlz and 64 bit multiplication
+ * - Added `PLAINLIBS_INTBUILTINS_FORCE_FALLBACK` to ignore compiler intrinsics
+ * - Fix compile error in overflowing_mul64s without GCC/Clang
+ * - Fix overflowing_add64s fallback truncating the result to 32 bits
+ * - Fix undefined behavior in the overflowing_mul64s fallback
+ * - The overflowing_mul64s fallback no longer uses division
+ * - Added full width multiplication (`plain_int_mul_wide64u/64s` and `plain_int_mul_high64u/64s`)
+ * - Added unsigned overflowing operations (`plain_int_overflowing_{add,sub,mul}{32,64}u`)
+ * - Added saturating operations (`plain_int_saturating_{add,sub,mul}{32,64}{s,u}`)
+ * - Added type-generic `plain_int_overflowing_{add,sub,mul}` and `plain_int_saturating_{add,sub,mul}` (requires C11)
+ * - Added ntz, popcount, parity, bitreverse and rotate (32 and 64 bit)
+ * - Added `plain_int_next_set_bit{32,64}` for iterating over set bits
+ * - Added `PLAIN_NLZ32_CONST` and `PLAIN_NLZ64_CONST` for use in constant expressions
  */
 #ifndef PLAINLIBS_INTBUILTIN_H
 #define PLAINLIBS_INTBUILTIN_H
@@ -34,22 +48,61 @@
 #include <assert.h>
 #include <stdlib.h>
 
+/*
+ * Selects which compiler intrinsics are used.
+ *
+ * GCC & Clang have builtins for everything here. MSVC has intrinsics for nlz
+ * and the high half of 64 bit multiplication, but it has nothing exposing the
+ * signed overflow flag (`_addcarry_u64` and `_subborrow_u64` only give the unsigned carry).
+ * The 32 bit operations and 64 bit add/sub fallbacks are already just a few
+ * plain instructions, so those are fine on MSVC.
+ *
+ * Define PLAINLIBS_INTBUILTINS_FORCE_FALLBACK to ignore the intrinsics and always use the
+ * portable fallbacks. This is useful to test & benchmark them with GCC/Clang.
+ */
+#if defined(PLAINLIBS_INTBUILTINS_FORCE_FALLBACK)
+// Only use portable code
+#elif defined(__GNUC__) || defined(__clang__)
+#define _PLAIN_INT_GNU_BUILTINS
+#elif defined(_MSC_VER)
+#define _PLAIN_INT_MSVC_INTRINSICS
+#include <intrin.h>
+#endif
+
 /*
  * I tend to make more reference to Java source than Rust
  *
  * This is because of `jshell`, not because I'm copy/pasting ;)
  */
 
-/**
- * Fallback implementation of nlz(int32_t)
+/*
+ * Selects the fallback implementation of nlz (used when compiler intrinsics are unavailable).
  *
- * This is used when compiler intrinsics are unavailable.
+ * - PLAINLIBS_NLZ_SIMPLE: The simple algorithm from Hacker's Delight (5-6 data-dependent branches)
+ * - PLAINLIBS_NLZ_BRANCHLESS: The branch-free binary search from Hacker's Delight
+ * - PLAINLIBS_NLZ_DEBRUIJN: Propagate the highest bit, then a de Bruijn multiply & table lookup (the default)
+ *
+ * The branches in the simple algorithm are unpredictable when the inputs have random magnitudes.
+ * Both other versions are branch-free, but the de Bruijn version is the fastest in `bench/intbuiltins.c`.
+ * Use the branchless version to avoid the (small) lookup tables.
+ *
+ * All of these return the bit width for nlz(0) (unlike the intrinsics).
  */
-static inline int _plain_int_nlz32_fallback(uint32_t x) {
+#define PLAINLIBS_NLZ_SIMPLE 1
+#define PLAINLIBS_NLZ_BRANCHLESS 2
+#define PLAINLIBS_NLZ_DEBRUIJN 3
+#ifndef PLAINLIBS_NLZ_FALLBACK
+#define PLAINLIBS_NLZ_FALLBACK PLAINLIBS_NLZ_DEBRUIJN
+#endif
+
+/**
+ * Implementation of nlz(int32_t) using the simple algorithm.
+ */
+static inline int _plain_int_nlz32_simple(uint32_t x) {
     /*
      * See Hacker's Delight
      *
-     * This is the simple algorithm. There is a branchless version.
+     * This is the simple algorithm. There is a branchless version (below).
      */
     uint32_t y;
     int n;
@@ -80,6 +133,89 @@ static inline int _plain_int_nlz32_fallback(uint32_t x) {
     return n - x;
 }
 
+/**
+ * Implementation of nlz(int32_t) without any branches.
+ */
+static inline int _plain_int_nlz32_branchless(uint32_t x) {
+    /*
+     * See Hacker's Delight 5-3, figure "Number of leading zeros, branch-free binary search".
+     *
+     * Each step subtracts a threshold, and uses the borrow (in the high bits)
+     * as a mask to decide whether to shift. The book uses signed arithmetic shifts,
+     * but only the masked bits matter so unsigned shifts are equivalent (and well-defined).
+     */
+    uint32_t y, m, n;
+    y = -(x >> 16);     // If left half of x is 0,
+    m = (y >> 16) & 16; // set n = 16. If left half
+    n = 16 - m;         // is nonzero, set n = 0 and
+    x = x >> m;         // shift x right 16.
+                        // Now x is of the form 0000xxxx.
+    y = x - 0x100;      // If positions 8-15 are 0,
+    m = (y >> 16) & 8;  // add 8 to n and shift x left 8.
+    n = n + m;
+    x = x << m;
+    y = x - 0x1000;    // If positions 12-15 are 0,
+    m = (y >> 16) & 4; // add 4 to n and shift x left 4.
+    n = n + m;
+    x = x << m;
+    y = x - 0x4000;    // If positions 14-15 are 0,
+    m = (y >> 16) & 2; // add 2 to n and shift x left 2.
+    n = n + m;
+    x = x << m;
+    y = x >> 14;       // Set y = 0, 1, 2, or 3.
+    m = y & ~(y >> 1); // Set m = 0, 1, 2, or 2 resp.
+    return (int)(n + 2 - m);
+}
+
+/*
+ * Maps the de Bruijn index of the highest set bit to nlz.
+ *
+ * Generated from the de Bruijn sequence 0x077CB531.
+ */
+static const unsigned char _PLAIN_INT_NLZ32_DEBRUIJN_TABLE[32] = {
+    31, 30, 3,  29, 2,  17, 7,  28, 1, 9,  11, 16, 6,  14, 27, 23,
+    0,  4,  18, 8,  10, 12, 15, 24, 5, 19, 13, 25, 20, 26, 21, 22,
+};
+
+/**
+ * Implementation of nlz(int32_t) using a de Bruijn multiplication and lookup table.
+ */
+static inline int _plain_int_nlz32_debruijn(uint32_t x) {
+    /*
+     * See Hacker's Delight 5-3 (and 5-4 for de Bruijn sequences)
+     *
+     * Propagating the highest bit rightwards then isolating it gives exactly 2^k.
+     * Multiplying a de Bruijn sequence by 2^k puts a unique 5-bit pattern in the top bits,
+     * which indexes the table.
+     */
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    uint32_t highest_bit = x - (x >> 1);
+    // nlz(0) == 32, which would otherwise be indistinguishable from nlz(1)
+    return _PLAIN_INT_NLZ32_DEBRUIJN_TABLE[(highest_bit * 0x077CB531u) >> 27] + (x == 0);
+}
+
+/**
+ * Fallback implementation of nlz(int32_t)
+ *
+ * This is used when compiler intrinsics are unavailable.
+ * The algorithm is selected by PLAINLIBS_NLZ_FALLBACK.
+ */
+static inline int _plain_int_nlz32_fallback(uint32_t x) {
+#if PLAINLIBS_NLZ_FALLBACK == PLAINLIBS_NLZ_SIMPLE
+    return _plain_int_nlz32_simple(x);
+#elif PLAINLIBS_NLZ_FALLBACK == PLAINLIBS_NLZ_BRANCHLESS
+    return _plain_int_nlz32_branchless(x);
+#elif PLAINLIBS_NLZ_FALLBACK == PLAINLIBS_NLZ_DEBRUIJN
+    return _plain_int_nlz32_debruijn(x);
+#else
+#error "Invalid PLAINLIBS_NLZ_FALLBACK"
+#endif
+}
+
 /**
  * Count the number of leading zeros in the specified integer.
  *
@@ -92,19 +228,24 @@ static inline int _plain_int_nlz32_fallback(uint32_t x) {
  */
 static inline int plain_int_nlz32(uint32_t val) {
     assert(val != 0);
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_clz(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(__AVX2__)
+    // Every CPU with AVX2 has LZCNT (on older CPUs it silently executes as BSR)
+    return (int)__lzcnt(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS)
+    unsigned long idx;
+    _BitScanReverse(&idx, (unsigned long)val);
+    return 31 - (int)idx;
 #else
     return _plain_int_nlz32_fallback(val);
 #endif
 }
 
 /**
- * Fallback implementation of nlz(int64_t)
- *
- * This is used when compiler intrinsics are unavailable.
+ * Implementation of nlz(int64_t) using the simple algorithm.
  */
-static inline int _plain_int_nlz64_fallback(uint64_t x) {
+static inline int _plain_int_nlz64_simple(uint64_t x) {
     /*
      * See Hacker's Delight
      *
@@ -140,6 +281,64 @@ static inline int _plain_int_nlz64_fallback(uint64_t x) {
     return (y == 0) ? n - ((int)x) : n - 2;
 }
 
+/**
+ * Implementation of nlz(int64_t) without any branches.
+ */
+static inline int _plain_int_nlz64_branchless(uint64_t x) {
+    /*
+     * One more step of the branch-free binary search (for the upper 32 bits),
+     * then the 32 bit version handles the rest.
+     */
+    uint64_t y = -(x >> 32);
+    uint32_t m = (uint32_t)(y >> 32) & 32; // 32 if the upper half is nonzero
+    x = x >> m;
+    return (int)(32 - m) + _plain_int_nlz32_branchless((uint32_t)x);
+}
+
+/*
+ * Maps the de Bruijn index of the highest set bit to nlz.
+ *
+ * Generated from the de Bruijn sequence 0x03F79D71B4CB0A89.
+ */
+static const unsigned char _PLAIN_INT_NLZ64_DEBRUIJN_TABLE[64] = {
+    63, 62, 15, 61, 6,  14, 35, 60, 2,  5,  13, 21, 25, 34, 46, 59, 1,  8,  4,  27, 10, 12,
+    20, 41, 18, 24, 30, 33, 39, 45, 51, 58, 0,  16, 7,  36, 3,  22, 26, 47, 9,  28, 11, 42,
+    19, 31, 40, 52, 17, 37, 23, 48, 29, 43, 32, 53, 38, 49, 44, 54, 50, 55, 56, 57,
+};
+
+/**
+ * Implementation of nlz(int64_t) using a de Bruijn multiplication and lookup table.
+ */
+static inline int _plain_int_nlz64_debruijn(uint64_t x) {
+    // See _plain_int_nlz32_debruijn
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+    x |= x >> 32;
+    uint64_t highest_bit = x - (x >> 1);
+    return _PLAIN_INT_NLZ64_DEBRUIJN_TABLE[(highest_bit * 0x03F79D71B4CB0A89u) >> 58] + (x == 0);
+}
+
+/**
+ * Fallback implementation of nlz(int64_t)
+ *
+ * This is used when compiler intrinsics are unavailable.
+ * The algorithm is selected by PLAINLIBS_NLZ_FALLBACK.
+ */
+static inline int _plain_int_nlz64_fallback(uint64_t x) {
+#if PLAINLIBS_NLZ_FALLBACK == PLAINLIBS_NLZ_SIMPLE
+    return _plain_int_nlz64_simple(x);
+#elif PLAINLIBS_NLZ_FALLBACK == PLAINLIBS_NLZ_BRANCHLESS
+    return _plain_int_nlz64_branchless(x);
+#elif PLAINLIBS_NLZ_FALLBACK == PLAINLIBS_NLZ_DEBRUIJN
+    return _plain_int_nlz64_debruijn(x);
+#else
+#error "Invalid PLAINLIBS_NLZ_FALLBACK"
+#endif
+}
+
 /*
  * Count the number of leading zeros in the specified integer.
  *
@@ -153,13 +352,584 @@ static inline int _plain_int_nlz64_fallback(uint64_t x) {
  */
 static inline int plain_int_nlz64(uint64_t val) {
     assert(val != 0);
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_clzll((unsigned long long)val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(__AVX2__) && defined(_M_X64)
+    return (int)__lzcnt64(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long idx;
+    _BitScanReverse64(&idx, val);
+    return 63 - (int)idx;
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS)
+    // 32 bit targets don't have _BitScanReverse64
+    unsigned long idx;
+    if (_BitScanReverse(&idx, (unsigned long)(val >> 32)))
+        return 31 - (int)idx;
+    _BitScanReverse(&idx, (unsigned long)val);
+    return 63 - (int)idx;
 #else
     return _plain_int_nlz64_fallback(val);
 #endif
 }
 
+/*
+ * Constant expression versions of nlz
+ *
+ * The functions above can't be used in array sizes, enum values or `_Static_assert`,
+ * because function calls are never integer constant expressions (even `static inline` ones).
+ *
+ * These macros count the powers of two that are greater than `val`,
+ * which is exactly the number of leading zeros.
+ * That expands to a sum of 32 (or 64) comparisons, which the compiler folds completely.
+ *
+ * Unlike the functions, these are well defined for zero (giving 32 or 64).
+ * The argument is evaluated many times, so it should be a constant.
+ * Don't use these at runtime.
+ */
+#define _PLAIN_NLZ_CONST_STEP(val, k) ((uint64_t)(val) < (UINT64_C(1) << (k)))
+#define _PLAIN_NLZ_CONST_8(val, k) \
+    (_PLAIN_NLZ_CONST_STEP(val, (k)) + _PLAIN_NLZ_CONST_STEP(val, (k) + 1) \
+    + _PLAIN_NLZ_CONST_STEP(val, (k) + 2) + _PLAIN_NLZ_CONST_STEP(val, (k) + 3) \
+    + _PLAIN_NLZ_CONST_STEP(val, (k) + 4) + _PLAIN_NLZ_CONST_STEP(val, (k) + 5) \
+    + _PLAIN_NLZ_CONST_STEP(val, (k) + 6) + _PLAIN_NLZ_CONST_STEP(val, (k) + 7))
+
+/**
+ * Count the number of leading zeros in a 32 bit constant.
+ *
+ * This is an integer constant expression, see plain_int_nlz32 for the runtime version.
+ */
+#define PLAIN_NLZ32_CONST(val) \
+    (_PLAIN_NLZ_CONST_8((uint32_t)(val), 0) + _PLAIN_NLZ_CONST_8((uint32_t)(val), 8) \
+    + _PLAIN_NLZ_CONST_8((uint32_t)(val), 16) + _PLAIN_NLZ_CONST_8((uint32_t)(val), 24))
+
+/**
+ * Count the number of leading zeros in a 64 bit constant.
+ *
+ * This is an integer constant expression, see plain_int_nlz64 for the runtime version.
+ */
+#define PLAIN_NLZ64_CONST(val) \
+    (_PLAIN_NLZ_CONST_8(val, 0) + _PLAIN_NLZ_CONST_8(val, 8) \
+    + _PLAIN_NLZ_CONST_8(val, 16) + _PLAIN_NLZ_CONST_8(val, 24) \
+    + _PLAIN_NLZ_CONST_8(val, 32) + _PLAIN_NLZ_CONST_8(val, 40) \
+    + _PLAIN_NLZ_CONST_8(val, 48) + _PLAIN_NLZ_CONST_8(val, 56))
+
+/*
+ * Other bit operations
+ *
+ * These are mostly for bitmaps & processing the masks from SIMD comparisons.
+ */
+
+/**
+ * Fallback implementation of ntz(int32_t)
+ *
+ * Like the nlz fallback, this returns 32 for ntz(0).
+ */
+static inline int _plain_int_ntz32_fallback(uint32_t x) {
+    /*
+     * See Hacker's Delight 5-4 "Counting Trailing 0's"
+     *
+     * `~x & (x - 1)` has ones exactly where x has trailing zeros,
+     * so this reuses whichever nlz fallback was selected.
+     */
+    return 32 - _plain_int_nlz32_fallback(~x & (x - 1));
+}
+
+/**
+ * Count the number of trailing zeros in the specified integer.
+ *
+ * See also:
+ * - GCC intrinsic __builtin_ctz
+ * - Java Integer.numberOfTrailingZeros
+ * - Rust u32::trailing_zeros
+ *
+ * Undefined behavior if the specified value is zero (matching GCC behavior).
+ */
+static inline int plain_int_ntz32(uint32_t val) {
+    assert(val != 0);
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_ctz(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(__AVX2__)
+    // Every CPU with AVX2 has BMI1
+    return (int)_tzcnt_u32(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS)
+    unsigned long idx;
+    _BitScanForward(&idx, (unsigned long)val);
+    return (int)idx;
+#else
+    return _plain_int_ntz32_fallback(val);
+#endif
+}
+
+/**
+ * Fallback implementation of ntz(int64_t)
+ *
+ * Like the nlz fallback, this returns 64 for ntz(0).
+ */
+static inline int _plain_int_ntz64_fallback(uint64_t x) {
+    // See _plain_int_ntz32_fallback
+    return 64 - _plain_int_nlz64_fallback(~x & (x - 1));
+}
+
+/**
+ * Count the number of trailing zeros in the specified integer.
+ *
+ * See also:
+ * - GCC intrinsic __builtin_ctzll
+ * - Java Long.numberOfTrailingZeros
+ * - Rust u64::trailing_zeros
+ *
+ * Undefined behavior if the specified value is zero (matching GCC behavior).
+ */
+static inline int plain_int_ntz64(uint64_t val) {
+    assert(val != 0);
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_ctzll((unsigned long long)val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(__AVX2__) && defined(_M_X64)
+    return (int)_tzcnt_u64(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long idx;
+    _BitScanForward64(&idx, val);
+    return (int)idx;
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS)
+    // 32 bit targets don't have _BitScanForward64
+    unsigned long idx;
+    if (_BitScanForward(&idx, (unsigned long)val))
+        return (int)idx;
+    _BitScanForward(&idx, (unsigned long)(val >> 32));
+    return 32 + (int)idx;
+#else
+    return _plain_int_ntz64_fallback(val);
+#endif
+}
+
+/**
+ * Fallback implementation of popcount(int32_t)
+ */
+static inline int _plain_int_popcount32_fallback(uint32_t x) {
+    /*
+     * See Hacker's Delight 5-1 "Counting 1-Bits", figure "Counting 1-bits in a word"
+     *
+     * Sum adjacent bits in parallel, then pairs of those sums, and so on.
+     * The final multiply adds all four byte sums into the top byte.
+     */
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (int)((x * 0x01010101u) >> 24);
+}
+
+/**
+ * Count the number of one bits in the specified integer.
+ *
+ * See also:
+ * - GCC intrinsic __builtin_popcount
+ * - Java Integer.bitCount
+ * - Rust u32::count_ones
+ */
+static inline int plain_int_popcount32(uint32_t val) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_popcount(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(__AVX__)
+    // The POPCNT instruction isn't checked for at runtime, every CPU with AVX has it
+    return (int)__popcnt(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_ARM64)
+    return (int)_CountOneBits(val);
+#else
+    return _plain_int_popcount32_fallback(val);
+#endif
+}
+
+/**
+ * Fallback implementation of popcount(int64_t)
+ */
+static inline int _plain_int_popcount64_fallback(uint64_t x) {
+    // See _plain_int_popcount32_fallback
+    x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+    x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+    x = (x + (x >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+    return (int)((x * UINT64_C(0x0101010101010101)) >> 56);
+}
+
+/**
+ * Count the number of one bits in the specified integer.
+ *
+ * See also:
+ * - GCC intrinsic __builtin_popcountll
+ * - Java Long.bitCount
+ * - Rust u64::count_ones
+ */
+static inline int plain_int_popcount64(uint64_t val) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_popcountll((unsigned long long)val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(__AVX__) && defined(_M_X64)
+    return (int)__popcnt64(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_ARM64)
+    return (int)_CountOneBits64(val);
+#else
+    return _plain_int_popcount64_fallback(val);
+#endif
+}
+
+/**
+ * Fallback implementation of parity(int32_t)
+ */
+static inline int _plain_int_parity32_fallback(uint32_t x) {
+    /*
+     * See Hacker's Delight 5-2 "Parity"
+     *
+     * Fold the word in half until only 4 bits are left,
+     * then look up their parity in the 16 bit constant.
+     */
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    return (int)((0x6996u >> (x & 0xF)) & 1);
+}
+
+/**
+ * The parity of the specified integer: 1 if an odd number of bits are set, otherwise 0.
+ *
+ * See also:
+ * - GCC intrinsic __builtin_parity
+ */
+static inline int plain_int_parity32(uint32_t val) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_parity(val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && (defined(__AVX__) || defined(_M_ARM64))
+    return plain_int_popcount32(val) & 1;
+#else
+    return _plain_int_parity32_fallback(val);
+#endif
+}
+
+/**
+ * Fallback implementation of parity(int64_t)
+ */
+static inline int _plain_int_parity64_fallback(uint64_t x) {
+    return _plain_int_parity32_fallback((uint32_t)(x ^ (x >> 32)));
+}
+
+/**
+ * The parity of the specified integer: 1 if an odd number of bits are set, otherwise 0.
+ *
+ * See also:
+ * - GCC intrinsic __builtin_parityll
+ */
+static inline int plain_int_parity64(uint64_t val) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_parityll((unsigned long long)val);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && (defined(__AVX__) || defined(_M_ARM64))
+    return plain_int_popcount64(val) & 1;
+#else
+    return _plain_int_parity64_fallback(val);
+#endif
+}
+
+/*
+ * Clang has bit reversal builtins, but GCC doesn't.
+ */
+#if defined(_PLAIN_INT_GNU_BUILTINS) && defined(__has_builtin)
+#if __has_builtin(__builtin_bitreverse32) && __has_builtin(__builtin_bitreverse64)
+#define _PLAIN_INT_HAVE_BITREVERSE_BUILTIN
+#endif
+#endif
+
+/**
+ * Fallback implementation of bitreverse(int32_t)
+ */
+static inline uint32_t _plain_int_bitreverse32_fallback(uint32_t x) {
+    /*
+     * See Hacker's Delight 7-1 "Reversing Bits and Bytes"
+     *
+     * Swap adjacent bits, then pairs, then nibbles, then bytes & halfwords.
+     */
+    x = ((x & 0x55555555u) << 1) | ((x >> 1) & 0x55555555u);
+    x = ((x & 0x33333333u) << 2) | ((x >> 2) & 0x33333333u);
+    x = ((x & 0x0F0F0F0Fu) << 4) | ((x >> 4) & 0x0F0F0F0Fu);
+    x = (x << 24) | ((x & 0xFF00u) << 8) | ((x >> 8) & 0xFF00u) | (x >> 24);
+    return x;
+}
+
+/**
+ * Reverse the order of the bits in the specified integer.
+ *
+ * See also:
+ * - Clang intrinsic __builtin_bitreverse32
+ * - Java Integer.reverse
+ * - Rust u32::reverse_bits
+ */
+static inline uint32_t plain_int_bitreverse32(uint32_t val) {
+#if defined(_PLAIN_INT_HAVE_BITREVERSE_BUILTIN)
+    return __builtin_bitreverse32(val);
+#else
+    return _plain_int_bitreverse32_fallback(val);
+#endif
+}
+
+/**
+ * Fallback implementation of bitreverse(int64_t)
+ */
+static inline uint64_t _plain_int_bitreverse64_fallback(uint64_t x) {
+    // Reverse each half, then swap them
+    return (((uint64_t)_plain_int_bitreverse32_fallback((uint32_t)x)) << 32) |
+           _plain_int_bitreverse32_fallback((uint32_t)(x >> 32));
+}
+
+/**
+ * Reverse the order of the bits in the specified integer.
+ *
+ * See also:
+ * - Clang intrinsic __builtin_bitreverse64
+ * - Java Long.reverse
+ * - Rust u64::reverse_bits
+ */
+static inline uint64_t plain_int_bitreverse64(uint64_t val) {
+#if defined(_PLAIN_INT_HAVE_BITREVERSE_BUILTIN)
+    return __builtin_bitreverse64(val);
+#else
+    return _plain_int_bitreverse64_fallback(val);
+#endif
+}
+
+/*
+ * Bitwise rotation
+ *
+ * The portable versions mask the shift amounts, so they are well defined for any `amount`
+ * (including zero). GCC, Clang and MSVC all recognize this pattern as a single rotate instruction.
+ */
+
+/**
+ * Rotate the bits left by the specified amount (modulo 32).
+ *
+ * See also:
+ * - MSVC intrinsic _rotl
+ * - Java Integer.rotateLeft
+ * - Rust u32::rotate_left
+ */
+static inline uint32_t plain_int_rotl32(uint32_t val, unsigned int amount) {
+#if defined(_PLAIN_INT_MSVC_INTRINSICS)
+    return _rotl(val, (int)(amount & 31));
+#else
+    return (val << (amount & 31)) | (val >> ((0u - amount) & 31));
+#endif
+}
+
+/**
+ * Rotate the bits right by the specified amount (modulo 32).
+ *
+ * See also:
+ * - MSVC intrinsic _rotr
+ * - Java Integer.rotateRight
+ * - Rust u32::rotate_right
+ */
+static inline uint32_t plain_int_rotr32(uint32_t val, unsigned int amount) {
+#if defined(_PLAIN_INT_MSVC_INTRINSICS)
+    return _rotr(val, (int)(amount & 31));
+#else
+    return (val >> (amount & 31)) | (val << ((0u - amount) & 31));
+#endif
+}
+
+/**
+ * Rotate the bits left by the specified amount (modulo 64).
+ *
+ * See also:
+ * - MSVC intrinsic _rotl64
+ * - Java Long.rotateLeft
+ * - Rust u64::rotate_left
+ */
+static inline uint64_t plain_int_rotl64(uint64_t val, unsigned int amount) {
+#if defined(_PLAIN_INT_MSVC_INTRINSICS)
+    return _rotl64(val, (int)(amount & 63));
+#else
+    return (val << (amount & 63)) | (val >> ((0u - amount) & 63));
+#endif
+}
+
+/**
+ * Rotate the bits right by the specified amount (modulo 64).
+ *
+ * See also:
+ * - MSVC intrinsic _rotr64
+ * - Java Long.rotateRight
+ * - Rust u64::rotate_right
+ */
+static inline uint64_t plain_int_rotr64(uint64_t val, unsigned int amount) {
+#if defined(_PLAIN_INT_MSVC_INTRINSICS)
+    return _rotr64(val, (int)(amount & 63));
+#else
+    return (val >> (amount & 63)) | (val << ((0u - amount) & 63));
+#endif
+}
+
+/*
+ * Iterating over set bits
+ *
+ * Clearing the lowest set bit with `bits & (bits - 1)` means each iteration
+ * only costs a ntz, regardless of how many zeros are skipped:
+ *
+ *     uint64_t remaining = bitmap;
+ *     while (remaining != 0) {
+ *         int idx = plain_int_next_set_bit64(&remaining);
+ *         // ... use idx ...
+ *     }
+ */
+
+/**
+ * Returns the index of the lowest set bit, and clears it.
+ *
+ * Undefined behavior if `*bits` is zero.
+ */
+static inline int plain_int_next_set_bit32(uint32_t* bits) {
+    uint32_t val = *bits;
+    int idx = plain_int_ntz32(val);
+    *bits = val & (val - 1);
+    return idx;
+}
+
+/**
+ * Returns the index of the lowest set bit, and clears it.
+ *
+ * Undefined behavior if `*bits` is zero.
+ */
+static inline int plain_int_next_set_bit64(uint64_t* bits) {
+    uint64_t val = *bits;
+    int idx = plain_int_ntz64(val);
+    *bits = val & (val - 1);
+    return idx;
+}
+
+/*
+ * Full width multiplication
+ *
+ * These give both halves of the 128 bit product of two 64 bit integers.
+ * This is useful for fixed-point math, multiplicative hashing,
+ * and reducing a hash into a range (the high half of `hash * n` is in [0, n)).
+ */
+
+#if defined(_PLAIN_INT_GNU_BUILTINS) && defined(__SIZEOF_INT128__)
+// __extension__ avoids -Wpedantic warnings
+__extension__ typedef unsigned __int128 _plain_int_u128;
+__extension__ typedef __int128 _plain_int_i128;
+#endif
+
+/**
+ * Fallback implementation of the full (128 bit) unsigned product.
+ */
+static inline uint64_t _plain_int_mul_wide64u_fallback(uint64_t first, uint64_t second, uint64_t* high) {
+    /*
+     * See Hacker's Delight Chapter 8-2 "Multiply high unsigned".
+     *
+     * Split into 32 bit halves and sum the four 32x32->64 bit partial products.
+     * None of the intermediate sums can overflow 64 bits.
+     */
+    uint64_t first_lo = first & UINT32_MAX, first_hi = first >> 32;
+    uint64_t second_lo = second & UINT32_MAX, second_hi = second >> 32;
+    uint64_t lo_lo = first_lo * second_lo;
+    uint64_t hi_lo = first_hi * second_lo;
+    uint64_t lo_hi = first_lo * second_hi;
+    uint64_t hi_hi = first_hi * second_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & UINT32_MAX) + lo_hi;
+    *high = hi_hi + (hi_lo >> 32) + (cross >> 32);
+    return (cross << 32) | (lo_lo & UINT32_MAX);
+}
+
+/**
+ * Unsigned full width multiplication.
+ *
+ * Returns the low 64 bits of the product, and stores the high 64 bits in `high`.
+ *
+ * See also:
+ * - GCC `unsigned __int128`
+ * - MSVC intrinsic _umul128
+ * - Java Math.unsignedMultiplyHigh(long, long) (for the high half)
+ * - Rust u64::widening_mul
+ */
+static inline uint64_t plain_int_mul_wide64u(uint64_t first, uint64_t second, uint64_t* high) {
+#if defined(_PLAIN_INT_GNU_BUILTINS) && defined(__SIZEOF_INT128__)
+    _plain_int_u128 product = ((_plain_int_u128)first) * second;
+    *high = (uint64_t)(product >> 64);
+    return (uint64_t)product;
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_X64)
+    return _umul128(first, second, high);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_ARM64)
+    *high = __umulh(first, second);
+    return first * second;
+#else
+    return _plain_int_mul_wide64u_fallback(first, second, high);
+#endif
+}
+
+/**
+ * Fallback implementation of the full (128 bit) signed product.
+ */
+static inline uint64_t _plain_int_mul_wide64s_fallback(int64_t first, int64_t second, int64_t* high) {
+    /*
+     * See Hacker's Delight Chapter 8-3 "High-Order Product Signed from/to Unsigned".
+     *
+     * The signed high half is the unsigned high half,
+     * minus each operand if the other one is negative.
+     */
+    uint64_t ufirst = (uint64_t)first;
+    uint64_t usecond = (uint64_t)second;
+    uint64_t uhigh;
+    uint64_t low = _plain_int_mul_wide64u_fallback(ufirst, usecond, &uhigh);
+    uhigh -= usecond & (0 - (ufirst >> 63));
+    uhigh -= ufirst & (0 - (usecond >> 63));
+    *high = (int64_t)uhigh;
+    return low;
+}
+
+/**
+ * Signed full width multiplication.
+ *
+ * Returns the low 64 bits of the product, and stores the high 64 bits in `high`.
+ * Together these are the twos complement representation of the 128 bit product,
+ * so the low half is unsigned (its top bit is not a sign bit).
+ *
+ * See also:
+ * - GCC `__int128`
+ * - MSVC intrinsic _mul128
+ * - Java Math.multiplyHigh(long, long) (for the high half)
+ * - Rust i64::widening_mul
+ */
+static inline uint64_t plain_int_mul_wide64s(int64_t first, int64_t second, int64_t* high) {
+#if defined(_PLAIN_INT_GNU_BUILTINS) && defined(__SIZEOF_INT128__)
+    _plain_int_i128 product = ((_plain_int_i128)first) * second;
+    *high = (int64_t)(product >> 64);
+    return (uint64_t)product;
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_X64)
+    return (uint64_t)_mul128(first, second, high);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_ARM64)
+    *high = __mulh(first, second);
+    return ((uint64_t)first) * ((uint64_t)second);
+#else
+    return _plain_int_mul_wide64s_fallback(first, second, high);
+#endif
+}
+
+/**
+ * The high half of the full (128 bit) unsigned product.
+ *
+ * See plain_int_mul_wide64u
+ */
+static inline uint64_t plain_int_mul_high64u(uint64_t first, uint64_t second) {
+    uint64_t high;
+    (void)plain_int_mul_wide64u(first, second, &high);
+    return high;
+}
+
+/**
+ * The high half of the full (128 bit) signed product.
+ *
+ * See plain_int_mul_wide64s
+ */
+static inline int64_t plain_int_mul_high64s(int64_t first, int64_t second) {
+    int64_t high;
+    (void)plain_int_mul_wide64s(first, second, &high);
+    return high;
+}
+
 /*
  * Overflow checking arithmetic operations
  *
@@ -200,7 +970,7 @@ static inline bool _plain_int_overflowing_add32s_fallback(int32_t first, int32_t
  * - Rust i32::overflowing_add
  */
 static inline bool plain_int_overflowing_add32s(int32_t first, int32_t second, int32_t* res) {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_add_overflow(first, second, res);
 #else
     return _plain_int_overflowing_add32s_fallback(first, second, res);
@@ -236,7 +1006,7 @@ static inline bool _plain_int_overflowing_sub32s_fallback(int32_t first, int32_t
  * - Rust i32::overflowing_add
  */
 static inline bool plain_int_overflowing_sub32s(int32_t first, int32_t second, int32_t* res) {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_sub_overflow(first, second, res);
 #else
     return _plain_int_overflowing_sub32s_fallback(first, second, res);
@@ -287,7 +1057,7 @@ static inline bool _plain_int_overflowing_mul32s_fallback(int32_t first, int32_t
  * - Rust i32::overflowing_mul
  */
 static inline bool plain_int_overflowing_mul32s(int32_t first, int32_t second, int32_t* res) {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_mul_overflow(first, second, res);
 #else
     return _plain_int_overflowing_mul32s_fallback(first, second, res);
@@ -306,7 +1076,7 @@ static inline bool _plain_int_overflowing_add64s_fallback(int64_t first, int64_t
     uint64_t ufirst = (uint64_t)first;
     uint64_t usecond = (uint64_t)second;
     uint64_t ures = ufirst + usecond;
-    *res = (int32_t)ures;
+    *res = (int64_t)ures;
     return (((ures ^ ufirst) & (ures ^ usecond)) >> 63) != 0;
 }
 
@@ -324,7 +1094,7 @@ static inline bool _plain_int_overflowing_add64s_fallback(int64_t first, int64_t
  * - Rust i64::overflowing_add
  */
 static inline bool plain_int_overflowing_add64s(int64_t first, int64_t second, int64_t* res) {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_add_overflow(first, second, res);
 #else
     return _plain_int_overflowing_add64s_fallback(first, second, res);
@@ -361,7 +1131,7 @@ static inline bool _plain_int_overflowing_sub64s_fallback(int64_t first, int64_t
  * - Rust i64::overflowing_sub
  */
 static inline bool plain_int_overflowing_sub64s(int64_t first, int64_t second, int64_t* res) {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_sub_overflow(first, second, res);
 #else
     return _plain_int_overflowing_sub64s_fallback(first, second, res);
@@ -369,11 +1139,13 @@ static inline bool plain_int_overflowing_sub64s(int64_t first, int64_t second, i
 }
 
 /**
- * Fallback implementation of subtractExact(long, long)
+ * Implementation of multiplyExact(long, long) using integer division.
+ *
+ * This was the original fallback, and is kept for benchmarking.
  *
  * This is complicated....
  */
-static inline bool _plain_int_overflowing_mul64s_fallback(int64_t first, int64_t second, int64_t* res) {
+static inline bool _plain_int_overflowing_mul64s_division(int64_t first, int64_t second, int64_t* res) {
     /*
      * See Hacker's Delight Chapter 2-13 section "Multiplication".
      *
@@ -415,7 +1187,6 @@ static inline bool _plain_int_overflowing_mul64s_fallback(int64_t first, int64_t
         return ufirst > 1;
     uint64_t first_abs = (uint64_t)llabs((long long)first);
     uint64_t second_abs = (uint64_t)llabs((long long)second);
-    assert(first_abs >= 0 && second_abs >= 0);
     /*
      * Overflow is impossible if
      * A. *either* absolute value <= 1,
@@ -443,14 +1214,47 @@ static inline bool _plain_int_overflowing_mul64s_fallback(int64_t first, int64_t
          *
          * Of course everything changes if nlz is a CPU builtin.
          * In that case we should use the other implmenetaiton....
+         *
+         * The magnitude limit is 2^63 - 1 if the signs are the same,
+         * and 2^63 if they differ (the result is negative).
          */
-        int64_t c = ((~(first ^ second)) >> 63) + (1LL << 63);
+        uint64_t c = ((uint64_t)INT64_MAX) + (((uint64_t)(first ^ second)) >> 63);
         return first_abs > (c / second_abs);
     }
 }
 
 /**
- * Signed integer subtraction, checking for overflow.
+ * Fallback implementation of multiplyExact(long, long)
+ *
+ * This computes the high half of the full product, and never uses division.
+ */
+static inline bool _plain_int_overflowing_mul64s_fallback(int64_t first, int64_t second, int64_t* res) {
+    /*
+     * The product fits in 64 bits exactly when the high half is the sign extension
+     * of the low half (all zeros or all ones, matching the low half's sign bit).
+     *
+     * Computing the high half is four multiplications and no division. The division in
+     * _plain_int_overflowing_mul64s_division costs tens of cycles when both operands are large
+     * (on older CPUs at least).
+     */
+    uint64_t ufirst = (uint64_t)first;
+    uint64_t usecond = (uint64_t)second;
+    uint64_t low = ufirst * usecond;
+    *res = (int64_t)low;
+    /*
+     * Fast path: Overflow is impossible if both fit in an int32_t (see mul32s_fallback).
+     *
+     * Adding 2^31 maps [INT32_MIN, INT32_MAX] to [0, UINT32_MAX].
+     */
+    if ((((ufirst + UINT64_C(0x80000000)) | (usecond + UINT64_C(0x80000000))) >> 32) == 0)
+        return false;
+    int64_t high;
+    (void)_plain_int_mul_wide64s_fallback(first, second, &high);
+    return high != -(int64_t)(low >> 63);
+}
+
+/**
+ * Signed integer multiplication, checking for overflow.
  *
  * Returns true if overflow occurs.
  *
@@ -463,11 +1267,491 @@ static inline bool _plain_int_overflowing_mul64s_fallback(int64_t first, int64_t
  * - Rust i64::overflowing_mul
  */
 static inline bool plain_int_overflowing_mul64s(int64_t first, int64_t second, int64_t* res) {
-#if defined(__GNUC__) || defined(__clang__)
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_mul_overflow(first, second, res);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && (defined(_M_X64) || defined(_M_ARM64))
+    int64_t high;
+    uint64_t low = plain_int_mul_wide64s(first, second, &high);
+    *res = (int64_t)low;
+    // Doesn't overflow if the high half is just the sign extension of the low half
+    return high != -(int64_t)(low >> 63);
+#else
+    return _plain_int_overflowing_mul64s_fallback(first, second, res);
+#endif
+}
+
+/*
+ * Unsigned overflow checking arithmetic operations
+ *
+ * Unsigned arithmetic always wraps in C, so the only question is whether it did.
+ * The fallbacks are all branchless (a comparison or checking the high half of a product).
+ */
+
+/**
+ * Fallback implementation of unsigned addition, checking for overflow.
+ */
+static inline bool _plain_int_overflowing_add32u_fallback(uint32_t first, uint32_t second, uint32_t* res) {
+    uint32_t ures = first + second;
+    *res = ures;
+    // Wrapping around means the result is smaller than either operand
+    return ures < first;
+}
+
+/**
+ * Unsigned integer addition, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * The result is computed using wrapping arithmetic,
+ * and it is computed unconditionally.
+ *
+ * See also:
+ * - GCC builtin __builtin_add_overflow()
+ * - Rust u32::overflowing_add
+ */
+static inline bool plain_int_overflowing_add32u(uint32_t first, uint32_t second, uint32_t* res) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_add_overflow(first, second, res);
+#else
+    return _plain_int_overflowing_add32u_fallback(first, second, res);
+#endif
+}
+
+/**
+ * Fallback implementation of unsigned subtraction, checking for overflow.
+ */
+static inline bool _plain_int_overflowing_sub32u_fallback(uint32_t first, uint32_t second, uint32_t* res) {
+    *res = first - second;
+    return first < second;
+}
+
+/**
+ * Unsigned integer subtraction, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * The result is computed using wrapping arithmetic,
+ * and it is computed unconditionally.
+ *
+ * See also:
+ * - GCC builtin __builtin_sub_overflow()
+ * - Rust u32::overflowing_sub
+ */
+static inline bool plain_int_overflowing_sub32u(uint32_t first, uint32_t second, uint32_t* res) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_sub_overflow(first, second, res);
+#else
+    return _plain_int_overflowing_sub32u_fallback(first, second, res);
+#endif
+}
+
+/**
+ * Fallback implementation of unsigned multiplication, checking for overflow.
+ */
+static inline bool _plain_int_overflowing_mul32u_fallback(uint32_t first, uint32_t second, uint32_t* res) {
+    // The full product always fits in 64 bits (see mul32s_fallback)
+    uint64_t bigres = ((uint64_t)first) * ((uint64_t)second);
+    *res = (uint32_t)bigres;
+    return (bigres >> 32) != 0;
+}
+
+/**
+ * Unsigned integer multiplication, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * The result is computed using wrapping arithmetic,
+ * and it is computed unconditionally.
+ *
+ * See also:
+ * - GCC builtin __builtin_mul_overflow()
+ * - Rust u32::overflowing_mul
+ */
+static inline bool plain_int_overflowing_mul32u(uint32_t first, uint32_t second, uint32_t* res) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_mul_overflow(first, second, res);
+#else
+    return _plain_int_overflowing_mul32u_fallback(first, second, res);
+#endif
+}
+
+/**
+ * Fallback implementation of unsigned addition, checking for overflow.
+ */
+static inline bool _plain_int_overflowing_add64u_fallback(uint64_t first, uint64_t second, uint64_t* res) {
+    uint64_t ures = first + second;
+    *res = ures;
+    // Wrapping around means the result is smaller than either operand
+    return ures < first;
+}
+
+/**
+ * Unsigned integer addition, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * The result is computed using wrapping arithmetic,
+ * and it is computed unconditionally.
+ *
+ * See also:
+ * - GCC builtin __builtin_add_overflow()
+ * - Rust u64::overflowing_add
+ */
+static inline bool plain_int_overflowing_add64u(uint64_t first, uint64_t second, uint64_t* res) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_add_overflow(first, second, res);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_X64)
+    return _addcarry_u64(0, first, second, res) != 0;
+#else
+    return _plain_int_overflowing_add64u_fallback(first, second, res);
+#endif
+}
+
+/**
+ * Fallback implementation of unsigned subtraction, checking for overflow.
+ */
+static inline bool _plain_int_overflowing_sub64u_fallback(uint64_t first, uint64_t second, uint64_t* res) {
+    *res = first - second;
+    return first < second;
+}
+
+/**
+ * Unsigned integer subtraction, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * The result is computed using wrapping arithmetic,
+ * and it is computed unconditionally.
+ *
+ * See also:
+ * - GCC builtin __builtin_sub_overflow()
+ * - Rust u64::overflowing_sub
+ */
+static inline bool plain_int_overflowing_sub64u(uint64_t first, uint64_t second, uint64_t* res) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
+    return __builtin_sub_overflow(first, second, res);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_X64)
+    return _subborrow_u64(0, first, second, res) != 0;
+#else
+    return _plain_int_overflowing_sub64u_fallback(first, second, res);
+#endif
+}
+
+/**
+ * Fallback implementation of unsigned multiplication, checking for overflow.
+ */
+static inline bool _plain_int_overflowing_mul64u_fallback(uint64_t first, uint64_t second, uint64_t* res) {
+    uint64_t high;
+    *res = _plain_int_mul_wide64u_fallback(first, second, &high);
+    return high != 0;
+}
+
+/**
+ * Unsigned integer multiplication, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * The result is computed using wrapping arithmetic,
+ * and it is computed unconditionally.
+ *
+ * See also:
+ * - GCC builtin __builtin_mul_overflow()
+ * - Rust u64::overflowing_mul
+ */
+static inline bool plain_int_overflowing_mul64u(uint64_t first, uint64_t second, uint64_t* res) {
+#if defined(_PLAIN_INT_GNU_BUILTINS)
     return __builtin_mul_overflow(first, second, res);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && (defined(_M_X64) || defined(_M_ARM64))
+    uint64_t high;
+    *res = plain_int_mul_wide64u(first, second, &high);
+    return high != 0;
 #else
-    return _plain_int_overflowing_mul64s(first, second, res);
+    return _plain_int_overflowing_mul64u_fallback(first, second, res);
 #endif
 }
 
+/*
+ * Saturating arithmetic operations
+ *
+ * Instead of wrapping, these clamp the result to the minimum/maximum value of the type.
+ *
+ * These are all implemented using the overflowing operations,
+ * then selecting the clamped value with a mask if overflow occurred.
+ * A ternary would be simpler, but GCC compiles it to a branch.
+ */
+
+/**
+ * Signed integer addition, clamping the result on overflow.
+ *
+ * See also:
+ * - Rust i32::saturating_add
+ */
+static inline int32_t plain_int_saturating_add32s(int32_t first, int32_t second) {
+    int32_t res;
+    bool overflow = plain_int_overflowing_add32s(first, second, &res);
+    // INT32_MAX if the true result is positive, otherwise INT32_MIN (via twos complement wrapping)
+    uint32_t clamped = ((uint32_t)INT32_MAX) + (((uint32_t)first) >> 31);
+    uint32_t mask = 0 - (uint32_t)overflow;
+    return (int32_t)(((uint32_t)res & ~mask) | (clamped & mask));
+}
+
+/**
+ * Signed integer subtraction, clamping the result on overflow.
+ *
+ * See also:
+ * - Rust i32::saturating_sub
+ */
+static inline int32_t plain_int_saturating_sub32s(int32_t first, int32_t second) {
+    int32_t res;
+    bool overflow = plain_int_overflowing_sub32s(first, second, &res);
+    // INT32_MAX if the true result is positive, otherwise INT32_MIN (via twos complement wrapping)
+    uint32_t clamped = ((uint32_t)INT32_MAX) + (((uint32_t)first) >> 31);
+    uint32_t mask = 0 - (uint32_t)overflow;
+    return (int32_t)(((uint32_t)res & ~mask) | (clamped & mask));
+}
+
+/**
+ * Signed integer multiplication, clamping the result on overflow.
+ *
+ * See also:
+ * - Rust i32::saturating_mul
+ */
+static inline int32_t plain_int_saturating_mul32s(int32_t first, int32_t second) {
+    int32_t res;
+    bool overflow = plain_int_overflowing_mul32s(first, second, &res);
+    // INT32_MAX if the true result is positive, otherwise INT32_MIN (via twos complement wrapping)
+    uint32_t clamped = ((uint32_t)INT32_MAX) + (((uint32_t)(first ^ second)) >> 31);
+    uint32_t mask = 0 - (uint32_t)overflow;
+    return (int32_t)(((uint32_t)res & ~mask) | (clamped & mask));
+}
+
+/**
+ * Unsigned integer addition, clamping the result on overflow.
+ *
+ * Overflow gives UINT32_MAX.
+ *
+ * See also:
+ * - Rust u32::saturating_add
+ */
+static inline uint32_t plain_int_saturating_add32u(uint32_t first, uint32_t second) {
+    uint32_t res;
+    bool overflow = plain_int_overflowing_add32u(first, second, &res);
+    return res | (0 - (uint32_t)overflow);
+}
+
+/**
+ * Unsigned integer subtraction, clamping the result on overflow.
+ *
+ * Underflow gives zero.
+ *
+ * See also:
+ * - Rust u32::saturating_sub
+ */
+static inline uint32_t plain_int_saturating_sub32u(uint32_t first, uint32_t second) {
+    uint32_t res;
+    bool overflow = plain_int_overflowing_sub32u(first, second, &res);
+    return res & ((uint32_t)overflow - 1);
+}
+
+/**
+ * Unsigned integer multiplication, clamping the result on overflow.
+ *
+ * Overflow gives UINT32_MAX.
+ *
+ * See also:
+ * - Rust u32::saturating_mul
+ */
+static inline uint32_t plain_int_saturating_mul32u(uint32_t first, uint32_t second) {
+    uint32_t res;
+    bool overflow = plain_int_overflowing_mul32u(first, second, &res);
+    return res | (0 - (uint32_t)overflow);
+}
+
+/**
+ * Signed integer addition, clamping the result on overflow.
+ *
+ * See also:
+ * - Rust i64::saturating_add
+ */
+static inline int64_t plain_int_saturating_add64s(int64_t first, int64_t second) {
+    int64_t res;
+    bool overflow = plain_int_overflowing_add64s(first, second, &res);
+    // INT64_MAX if the true result is positive, otherwise INT64_MIN (via twos complement wrapping)
+    uint64_t clamped = ((uint64_t)INT64_MAX) + (((uint64_t)first) >> 63);
+    uint64_t mask = 0 - (uint64_t)overflow;
+    return (int64_t)(((uint64_t)res & ~mask) | (clamped & mask));
+}
+
+/**
+ * Signed integer subtraction, clamping the result on overflow.
+ *
+ * See also:
+ * - Rust i64::saturating_sub
+ */
+static inline int64_t plain_int_saturating_sub64s(int64_t first, int64_t second) {
+    int64_t res;
+    bool overflow = plain_int_overflowing_sub64s(first, second, &res);
+    // INT64_MAX if the true result is positive, otherwise INT64_MIN (via twos complement wrapping)
+    uint64_t clamped = ((uint64_t)INT64_MAX) + (((uint64_t)first) >> 63);
+    uint64_t mask = 0 - (uint64_t)overflow;
+    return (int64_t)(((uint64_t)res & ~mask) | (clamped & mask));
+}
+
+/**
+ * Signed integer multiplication, clamping the result on overflow.
+ *
+ * See also:
+ * - Rust i64::saturating_mul
+ */
+static inline int64_t plain_int_saturating_mul64s(int64_t first, int64_t second) {
+    int64_t res;
+    bool overflow = plain_int_overflowing_mul64s(first, second, &res);
+    // INT64_MAX if the true result is positive, otherwise INT64_MIN (via twos complement wrapping)
+    uint64_t clamped = ((uint64_t)INT64_MAX) + (((uint64_t)(first ^ second)) >> 63);
+    uint64_t mask = 0 - (uint64_t)overflow;
+    return (int64_t)(((uint64_t)res & ~mask) | (clamped & mask));
+}
+
+/**
+ * Unsigned integer addition, clamping the result on overflow.
+ *
+ * Overflow gives UINT64_MAX.
+ *
+ * See also:
+ * - Rust u64::saturating_add
+ */
+static inline uint64_t plain_int_saturating_add64u(uint64_t first, uint64_t second) {
+    uint64_t res;
+    bool overflow = plain_int_overflowing_add64u(first, second, &res);
+    return res | (0 - (uint64_t)overflow);
+}
+
+/**
+ * Unsigned integer subtraction, clamping the result on overflow.
+ *
+ * Underflow gives zero.
+ *
+ * See also:
+ * - Rust u64::saturating_sub
+ */
+static inline uint64_t plain_int_saturating_sub64u(uint64_t first, uint64_t second) {
+    uint64_t res;
+    bool overflow = plain_int_overflowing_sub64u(first, second, &res);
+    return res & ((uint64_t)overflow - 1);
+}
+
+/**
+ * Unsigned integer multiplication, clamping the result on overflow.
+ *
+ * Overflow gives UINT64_MAX.
+ *
+ * See also:
+ * - Rust u64::saturating_mul
+ */
+static inline uint64_t plain_int_saturating_mul64u(uint64_t first, uint64_t second) {
+    uint64_t res;
+    bool overflow = plain_int_overflowing_mul64u(first, second, &res);
+    return res | (0 - (uint64_t)overflow);
+}
+
+/*
+ * Type-generic versions of the overflowing & saturating operations.
+ *
+ * These require C11 (for _Generic), but the rest of this header only needs C99.
+ *
+ * The overflowing operations select the width & signedness based on the type of the result pointer.
+ * This makes them a bit stricter than the GCC builtins, which accept any combination of types.
+ *
+ * Like `plain_max` in minmax.h, the saturating operations select the type
+ * based on the first argument. Smaller integer types are promoted to int,
+ * so use int32_t. Types other than int32_t, uint32_t, int64_t, and uint64_t are a compile error.
+ */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+
+/**
+ * Integer addition, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * Dispatches based on the type of `res` to plain_int_overflowing_add{32,64}{s,u}
+ */
+#define plain_int_overflowing_add(first, second, res) \
+    _Generic((res), \
+        int32_t*: plain_int_overflowing_add32s, \
+        uint32_t*: plain_int_overflowing_add32u, \
+        int64_t*: plain_int_overflowing_add64s, \
+        uint64_t*: plain_int_overflowing_add64u \
+    )(first, second, res)
+
+/**
+ * Integer subtraction, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * Dispatches based on the type of `res` to plain_int_overflowing_sub{32,64}{s,u}
+ */
+#define plain_int_overflowing_sub(first, second, res) \
+    _Generic((res), \
+        int32_t*: plain_int_overflowing_sub32s, \
+        uint32_t*: plain_int_overflowing_sub32u, \
+        int64_t*: plain_int_overflowing_sub64s, \
+        uint64_t*: plain_int_overflowing_sub64u \
+    )(first, second, res)
+
+/**
+ * Integer multiplication, checking for overflow.
+ *
+ * Returns true if overflow occurs.
+ *
+ * Dispatches based on the type of `res` to plain_int_overflowing_mul{32,64}{s,u}
+ */
+#define plain_int_overflowing_mul(first, second, res) \
+    _Generic((res), \
+        int32_t*: plain_int_overflowing_mul32s, \
+        uint32_t*: plain_int_overflowing_mul32u, \
+        int64_t*: plain_int_overflowing_mul64s, \
+        uint64_t*: plain_int_overflowing_mul64u \
+    )(first, second, res)
+
+/**
+ * Integer addition, clamping the result on overflow.
+ *
+ * Dispatches based on the type of `first` to plain_int_saturating_add{32,64}{s,u}
+ */
+#define plain_int_saturating_add(first, second) \
+    _Generic((first), \
+        int32_t: plain_int_saturating_add32s, \
+        uint32_t: plain_int_saturating_add32u, \
+        int64_t: plain_int_saturating_add64s, \
+        uint64_t: plain_int_saturating_add64u \
+    )(first, second)
+
+/**
+ * Integer subtraction, clamping the result on overflow.
+ *
+ * Dispatches based on the type of `first` to plain_int_saturating_sub{32,64}{s,u}
+ */
+#define plain_int_saturating_sub(first, second) \
+    _Generic((first), \
+        int32_t: plain_int_saturating_sub32s, \
+        uint32_t: plain_int_saturating_sub32u, \
+        int64_t: plain_int_saturating_sub64s, \
+        uint64_t: plain_int_saturating_sub64u \
+    )(first, second)
+
+/**
+ * Integer multiplication, clamping the result on overflow.
+ *
+ * Dispatches based on the type of `first` to plain_int_saturating_mul{32,64}{s,u}
+ */
+#define plain_int_saturating_mul(first, second) \
+    _Generic((first), \
+        int32_t: plain_int_saturating_mul32s, \
+        uint32_t: plain_int_saturating_mul32u, \
+        int64_t: plain_int_saturating_mul64s, \
+        uint64_t: plain_int_saturating_mul64u \
+    )(first, second)
+
+#endif /* C11 */
+
 #endif /* PLAINLIBS_INTBUILTIN_H */
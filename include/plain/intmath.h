@@ -21,12 +21,195 @@
  *
  * NEXT:
  * - Initial release
+ * - Added `struct plain_int_checked`, for chaining arithmetic with a single "sticky" overflow check
+ * - Added `PLAIN_ILOG2_CONST` and `PLAIN_NEXT_POW2_CONST` for use in constant expressions
+ * - Added the rest of the pow family: `plain_int_pow{32,64}{s,u}_{overflowing,wrapping,saturating}`
+ *   and `plain_int_checked_pow{32,64}{s,u}`
+ * - The checked & saturating pow functions check for overflow using a table of the maximum base for each exponent
+ * - Added `PLAIN_INT_POW{32,64}{S,U}_OVERFLOWING_CONST`, using addition chains for constant exponents
+ * - Added `plain_int_ilog2`, `plain_int_ilog10` and `plain_int_decimal_digits` (32/64 bit, signed & unsigned)
+ * - Added `struct plain_int_divider{32,64}{s,u}`, for fast division, remainder & divisibility by a reused divisor
+ *   (with batch versions for arrays)
+ * - Added `plain_int_mul_div64{s,u}` and the fixed-point `plain_int_mul_q{32,64}{s,u}`,
+ *   which never overflow in the intermediate product and support several rounding modes
  */
 #ifndef PLAINLIBS_INTMATH_H
 #define PLAINLIBS_INTMATH_H
 
 #include "plain/intbuiltins.h"
 
+/*
+ * Constant expression versions of log2 & next power of two.
+ *
+ * These are for sizing static tables (array bounds, enum values, `_Static_assert`):
+ *     #define TABLE_SIZE PLAIN_NEXT_POW2_CONST(NUM_ENTRIES)
+ *     enum { TABLE_SHIFT = PLAIN_ILOG2_CONST(TABLE_SIZE) };
+ *     static struct entry table[TABLE_SIZE];
+ *
+ * Like PLAIN_NLZ64_CONST (which they are based on),
+ * the argument is evaluated many times so these shouldn't be used at runtime.
+ */
+
+/**
+ * The base 2 logarithm of a constant, rounded down.
+ *
+ * This is the index of the highest set bit (so it is -1 for zero).
+ */
+#define PLAIN_ILOG2_CONST(val) (63 - PLAIN_NLZ64_CONST(val))
+
+/**
+ * The smallest power of two greater than or equal to a constant (as a uint64_t).
+ *
+ * This gives 1 for both zero and one.
+ * Values greater than 2^63 have no result that fits in 64 bits, and wrap around to 1.
+ */
+#define PLAIN_NEXT_POW2_CONST(val) \
+    (UINT64_C(1) << ((64 - PLAIN_NLZ64_CONST((uint64_t)(val) - 1)) & 63))
+
+/*
+ * Integer logarithms & counting decimal digits
+ *
+ * These are all computed from nlz, without any division loops.
+ * The base 2 logarithm is just the index of the highest set bit.
+ *
+ * The base 10 logarithm starts from an estimate based on the base 2 logarithm:
+ * log10(x) = log2(x) * log10(2), and log10(2) is approximately 1233/4096.
+ * Using `log2(x) + 1` makes the estimate either exact or one too large,
+ * which is fixed by a single comparison against a table of powers of ten.
+ * See Hacker's Delight 11-4 "Integer Logarithm" (and "Bit Twiddling Hacks").
+ *
+ * The logarithms of zero (and negative numbers) are undefined,
+ * so these return -1 just like PLAIN_ILOG2_CONST.
+ * Zero has a single decimal digit, and negative numbers count the digits of their magnitude
+ * (not including the minus sign).
+ */
+
+/**
+ * The base 2 logarithm, rounded down (or -1 if the value is zero).
+ *
+ * See also:
+ * - Rust u32::checked_ilog2
+ */
+static inline int plain_int_ilog2_32u(uint32_t val) {
+    return val == 0 ? -1 : 31 - plain_int_nlz32(val);
+}
+
+/**
+ * The base 2 logarithm, rounded down (or -1 if the value is zero).
+ *
+ * See also:
+ * - Rust u64::checked_ilog2
+ */
+static inline int plain_int_ilog2_64u(uint64_t val) {
+    return val == 0 ? -1 : 63 - plain_int_nlz64(val);
+}
+
+/**
+ * The base 2 logarithm, rounded down (or -1 if the value isn't positive).
+ */
+static inline int plain_int_ilog2_32s(int32_t val) {
+    return val <= 0 ? -1 : plain_int_ilog2_32u((uint32_t) val);
+}
+
+/**
+ * The base 2 logarithm, rounded down (or -1 if the value isn't positive).
+ */
+static inline int plain_int_ilog2_64s(int64_t val) {
+    return val <= 0 ? -1 : plain_int_ilog2_64u((uint64_t) val);
+}
+
+/**
+ * The base 10 logarithm, rounded down (or -1 if the value is zero).
+ *
+ * See also:
+ * - Rust u32::checked_ilog10
+ */
+static inline int plain_int_ilog10_32u(uint32_t val) {
+    static const uint32_t powers_of_ten[10] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+    /*
+     * Or-ing with one avoids nlz(0), and still gives the right answer:
+     * The estimate for one is zero, and then 0 < 10^0 gives -1.
+     */
+    int estimate = ((31 - plain_int_nlz32(val | 1)) + 1) * 1233 >> 12;
+    return estimate - (val < powers_of_ten[estimate]);
+}
+
+/**
+ * The base 10 logarithm, rounded down (or -1 if the value is zero).
+ *
+ * See also:
+ * - Rust u64::checked_ilog10
+ */
+static inline int plain_int_ilog10_64u(uint64_t val) {
+    static const uint64_t powers_of_ten[20] = {
+        UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+        UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000),
+        UINT64_C(1000000000), UINT64_C(10000000000), UINT64_C(100000000000),
+        UINT64_C(1000000000000), UINT64_C(10000000000000), UINT64_C(100000000000000),
+        UINT64_C(1000000000000000), UINT64_C(10000000000000000), UINT64_C(100000000000000000),
+        UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+    };
+    // See plain_int_ilog10_32u
+    int estimate = ((63 - plain_int_nlz64(val | 1)) + 1) * 1233 >> 12;
+    return estimate - (val < powers_of_ten[estimate]);
+}
+
+/**
+ * The base 10 logarithm, rounded down (or -1 if the value isn't positive).
+ */
+static inline int plain_int_ilog10_32s(int32_t val) {
+    return val <= 0 ? -1 : plain_int_ilog10_32u((uint32_t) val);
+}
+
+/**
+ * The base 10 logarithm, rounded down (or -1 if the value isn't positive).
+ */
+static inline int plain_int_ilog10_64s(int64_t val) {
+    return val <= 0 ? -1 : plain_int_ilog10_64u((uint64_t) val);
+}
+
+/**
+ * The number of decimal digits needed to print the value.
+ *
+ * Zero has a single digit.
+ */
+static inline int plain_int_decimal_digits32u(uint32_t val) {
+    // Zero has the same number of digits as one
+    return plain_int_ilog10_32u(val | 1) + 1;
+}
+
+/**
+ * The number of decimal digits needed to print the value.
+ *
+ * Zero has a single digit.
+ */
+static inline int plain_int_decimal_digits64u(uint64_t val) {
+    return plain_int_ilog10_64u(val | 1) + 1;
+}
+
+/**
+ * The number of decimal digits needed to print the value, not including the minus sign.
+ *
+ * Zero has a single digit.
+ */
+static inline int plain_int_decimal_digits32s(int32_t val) {
+    // Negating in unsigned arithmetic works for INT32_MIN
+    uint32_t magnitude = val < 0 ? 0u - (uint32_t) val : (uint32_t) val;
+    return plain_int_decimal_digits32u(magnitude);
+}
+
+/**
+ * The number of decimal digits needed to print the value, not including the minus sign.
+ *
+ * Zero has a single digit.
+ */
+static inline int plain_int_decimal_digits64s(int64_t val) {
+    uint64_t magnitude = val < 0 ? 0u - (uint64_t) val : (uint64_t) val;
+    return plain_int_decimal_digits64u(magnitude);
+}
+
 
 /*
  * Okay. Exponentation by squaring is a pretty simple idea.
@@ -142,30 +325,1425 @@
         return overflowing; \
     } while (false)
 
+/*
+ * The same loop, without checking for overflow.
+ */
+#define _IMPL_EXP_BY_SQUARING_WRAPPING(tp) do { \
+        uint32_t remaining_bits = exp; \
+        tp current_res = 1; \
+        tp current_power = base; \
+        if (remaining_bits & 1) { \
+            current_res = base; \
+        } \
+        while (remaining_bits >= 2) { \
+            current_power *= current_power; \
+            if (remaining_bits & 2) { \
+                current_res *= current_power; \
+            } \
+            remaining_bits >>= 1; \
+        } \
+        return current_res; \
+    } while (false)
+
 /**
  * Raises `base` to the power of `exp`, using exponentiation by squaring.
- * 
- * Returns true if overflow occurred, false if it has not.
  *
- * This mirrors Rust's i64::overflowing_pow
+ * Wraps around on the boundary of the type, ignoring overflow.
+ *
+ * This mirrors Rust's u32::wrapping_pow
  */
-static inline bool plain_int_pow64s_overflowing(int64_t base, uint32_t exp, int64_t *res) {
-    _IMPL_EXP_BY_SQUARING_OVERFLOWING(int64_t, plain_int_overflowing_mul64s);
+static inline uint32_t plain_int_pow32u_wrapping(uint32_t base, uint32_t exp) {
+    _IMPL_EXP_BY_SQUARING_WRAPPING(uint32_t);
 }
 
+/**
+ * Raises `base` to the power of `exp`, using exponentiation by squaring.
+ *
+ * Wraps around on the boundary of the type, ignoring overflow.
+ *
+ * This mirrors Rust's u64::wrapping_pow
+ */
+static inline uint64_t plain_int_pow64u_wrapping(uint64_t base, uint32_t exp) {
+    _IMPL_EXP_BY_SQUARING_WRAPPING(uint64_t);
+}
+
+#undef _IMPL_EXP_BY_SQUARING_WRAPPING
 
 /**
  * Raises `base` to the power of `exp`, using exponentiation by squaring.
- * 
+ *
  * Wraps around on the boundary of the type, ignoring overflow.
- * 
+ *
+ * This mirrors Rust's i32::wrapping_pow
+ */
+static inline int32_t plain_int_pow32s_wrapping(int32_t base, uint32_t exp) {
+    // Twos complement multiplication is the same for signed & unsigned
+    return (int32_t) plain_int_pow32u_wrapping((uint32_t) base, exp);
+}
+
+/**
+ * Raises `base` to the power of `exp`, using exponentiation by squaring.
+ *
+ * Wraps around on the boundary of the type, ignoring overflow.
+ *
  * This mirrors Rust's i64::wrapping_pow
  */
-static inline int64_t plain_int_pow64s_wrapping(int64_t base, uint32_t power) {
-    int64_t res;
-    // This relies on DCE being good ;)
-    plain_int_pow64s_overflowing(base, power, &res);
+static inline int64_t plain_int_pow64s_wrapping(int64_t base, uint32_t exp) {
+    return (int64_t) plain_int_pow64u_wrapping((uint64_t) base, exp);
+}
+
+/*
+ * Checking for overflow
+ *
+ * Checking each multiplication is slow, and keeps going after overflow has already happened.
+ * Instead, look up the range of bases that don't overflow for each exponent.
+ * Because |base|^exp only grows with |base|, that's a single comparison (or two, if signed).
+ *
+ * Once the exponent is at least the bit width, only -1, 0 and 1 don't overflow.
+ *
+ * Negative bases with an odd exponent can go one further when the result is exactly the minimum,
+ * for example (-2)^63 == INT64_MIN, but 2^63 > INT64_MAX.
+ */
+
+/**
+ * If `base` to the power of `exp` fits in an uint32_t.
+ */
+static inline bool _plain_int_pow32u_fits(uint32_t base, uint32_t exp) {
+    static const uint32_t max_base[32] = {
+        UINT32_MAX, UINT32_MAX, 65535, 1625, 255, 84, 40, 23,
+        15, 11, 9, 7, 6, 5, 4, 4,
+        3, 3, 3, 3, 3, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2
+    };
+    return exp < 32 ? base <= max_base[exp] : base <= 1;
+}
+
+/**
+ * If `base` to the power of `exp` fits in an uint64_t.
+ */
+static inline bool _plain_int_pow64u_fits(uint64_t base, uint32_t exp) {
+    static const uint64_t max_base[64] = {
+        UINT64_MAX, UINT64_MAX, UINT64_C(4294967295), 2642245, 65535, 7131, 1625, 565,
+        255, 138, 84, 56, 40, 30, 23, 19,
+        15, 13, 11, 10, 9, 8, 7, 6,
+        6, 5, 5, 5, 4, 4, 4, 4,
+        3, 3, 3, 3, 3, 3, 3, 3,
+        3, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2
+    };
+    return exp < 64 ? base <= max_base[exp] : base <= 1;
+}
+
+/**
+ * If `base` to the power of `exp` fits in an int32_t.
+ */
+static inline bool _plain_int_pow32s_fits(int32_t base, uint32_t exp) {
+    static const int32_t max_base[32] = {
+        INT32_MAX, INT32_MAX, 46340, 1290, 215, 73, 35, 21,
+        14, 10, 8, 7, 5, 5, 4, 4,
+        3, 3, 3, 3, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 1
+    };
+    static const int32_t min_base[32] = {
+        INT32_MIN, INT32_MIN, -46340, -1290, -215, -73, -35, -21,
+        -14, -10, -8, -7, -5, -5, -4, -4,
+        -3, -3, -3, -3, -2, -2, -2, -2,
+        -2, -2, -2, -2, -2, -2, -2, -2
+    };
+    if (exp >= 32) return base >= -1 && base <= 1;
+    return base >= min_base[exp] && base <= max_base[exp];
+}
+
+/**
+ * If `base` to the power of `exp` fits in an int64_t.
+ */
+static inline bool _plain_int_pow64s_fits(int64_t base, uint32_t exp) {
+    static const int64_t max_base[64] = {
+        INT64_MAX, INT64_MAX, INT64_C(3037000499), 2097151, 55108, 6208, 1448, 511,
+        234, 127, 78, 52, 38, 28, 22, 18,
+        15, 13, 11, 9, 8, 7, 7, 6,
+        6, 5, 5, 5, 4, 4, 4, 4,
+        3, 3, 3, 3, 3, 3, 3, 3,
+        2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 2,
+        2, 2, 2, 2, 2, 2, 2, 1
+    };
+    static const int64_t min_base[64] = {
+        INT64_MIN, INT64_MIN, INT64_C(-3037000499), -2097152, -55108, -6208, -1448, -512,
+        -234, -128, -78, -52, -38, -28, -22, -18,
+        -15, -13, -11, -9, -8, -8, -7, -6,
+        -6, -5, -5, -5, -4, -4, -4, -4,
+        -3, -3, -3, -3, -3, -3, -3, -3,
+        -2, -2, -2, -2, -2, -2, -2, -2,
+        -2, -2, -2, -2, -2, -2, -2, -2,
+        -2, -2, -2, -2, -2, -2, -2, -2
+    };
+    if (exp >= 64) return base >= -1 && base <= 1;
+    return base >= min_base[exp] && base <= max_base[exp];
+}
+
+#define _PLAIN_IMPL_POW_OVERFLOWING(tp, suffix) \
+    static inline bool plain_int_pow ## suffix ## _overflowing(tp base, uint32_t exp, tp *res) { \
+        _IMPL_EXP_BY_SQUARING_OVERFLOWING(tp, plain_int_overflowing_mul ## suffix); \
+    }
+
+/*
+ * Defines plain_int_pow{32,64}{s,u}_overflowing
+ *
+ * Each of these raises `base` to the power of `exp`, using exponentiation by squaring.
+ * Returns true if overflow occurred, false if it has not.
+ * The result is computed using twos complement wrapping.
+ *
+ * These need the wrapped result, so they can't stop early.
+ * Checking each multiplication turns out to be faster than the wrapping loop plus a table lookup.
+ *
+ * This mirrors Rust's i64::overflowing_pow
+ */
+_PLAIN_IMPL_POW_OVERFLOWING(int32_t, 32s)
+_PLAIN_IMPL_POW_OVERFLOWING(uint32_t, 32u)
+_PLAIN_IMPL_POW_OVERFLOWING(int64_t, 64s)
+_PLAIN_IMPL_POW_OVERFLOWING(uint64_t, 64u)
+
+#undef _PLAIN_IMPL_POW_OVERFLOWING
+#undef _IMPL_EXP_BY_SQUARING_OVERFLOWING
+
+/**
+ * Raises `base` to the power of `exp`, saturating at the boundary of the type.
+ *
+ * This returns immediately if the result would overflow.
+ *
+ * This mirrors Rust's u32::saturating_pow
+ */
+static inline uint32_t plain_int_pow32u_saturating(uint32_t base, uint32_t exp) {
+    if (!_plain_int_pow32u_fits(base, exp)) return UINT32_MAX;
+    return plain_int_pow32u_wrapping(base, exp);
+}
+
+/**
+ * Raises `base` to the power of `exp`, saturating at the boundary of the type.
+ *
+ * This returns immediately if the result would overflow.
+ *
+ * This mirrors Rust's u64::saturating_pow
+ */
+static inline uint64_t plain_int_pow64u_saturating(uint64_t base, uint32_t exp) {
+    if (!_plain_int_pow64u_fits(base, exp)) return UINT64_MAX;
+    return plain_int_pow64u_wrapping(base, exp);
+}
+
+/**
+ * Raises `base` to the power of `exp`, saturating at the boundary of the type.
+ *
+ * Negative bases with an odd exponent saturate to INT32_MIN, everything else to INT32_MAX.
+ * This returns immediately if the result would overflow.
+ *
+ * This mirrors Rust's i32::saturating_pow
+ */
+static inline int32_t plain_int_pow32s_saturating(int32_t base, uint32_t exp) {
+    if (!_plain_int_pow32s_fits(base, exp)) return base < 0 && (exp & 1) ? INT32_MIN : INT32_MAX;
+    return plain_int_pow32s_wrapping(base, exp);
+}
+
+/**
+ * Raises `base` to the power of `exp`, saturating at the boundary of the type.
+ *
+ * Negative bases with an odd exponent saturate to INT64_MIN, everything else to INT64_MAX.
+ * This returns immediately if the result would overflow.
+ *
+ * This mirrors Rust's i64::saturating_pow
+ */
+static inline int64_t plain_int_pow64s_saturating(int64_t base, uint32_t exp) {
+    if (!_plain_int_pow64s_fits(base, exp)) return base < 0 && (exp & 1) ? INT64_MIN : INT64_MAX;
+    return plain_int_pow64s_wrapping(base, exp);
+}
+
+/*
+ * Raising to a constant power
+ *
+ * The loop above handles any exponent, but most exponents are constants (squares, cubes, 10^k).
+ * For those, an addition chain gives the fewest multiplications:
+ * Each power is the product of two earlier ones (for example x^10 = x^5 * x^5).
+ * This is never longer than squaring, and sometimes shorter (x^15 takes 5 multiplications instead of 6).
+ * See also Knuth TAOCP Vol 2, 4.6.3 "Evaluation of Powers".
+ *
+ * The overflow flags of every multiplication are ORed together.
+ * Every intermediate power has a smaller magnitude than the result,
+ * so this only reports overflow if the final result overflows.
+ *
+ * There are no loops or branches, just a fixed sequence of multiplications.
+ *
+ * These are selected by pasting the exponent into the function name,
+ * so the exponent must be an integer literal from 0 to 20 (or a macro that expands to one).
+ * Anything else is a compile error.
+ */
+
+#define _PLAIN_POW_CHAIN_2(tp, mul) \
+    tp x2; \
+    overflow |= mul(x, x, &x2); \
+    *res = x2
+#define _PLAIN_POW_CHAIN_3(tp, mul) \
+    tp x2, x3; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    *res = x3
+#define _PLAIN_POW_CHAIN_4(tp, mul) \
+    tp x2, x4; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    *res = x4
+#define _PLAIN_POW_CHAIN_5(tp, mul) \
+    tp x2, x4, x5; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x, &x5); \
+    *res = x5
+#define _PLAIN_POW_CHAIN_6(tp, mul) \
+    tp x2, x3, x6; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x3, &x6); \
+    *res = x6
+#define _PLAIN_POW_CHAIN_7(tp, mul) \
+    tp x2, x3, x5, x7; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x2, &x5); \
+    overflow |= mul(x5, x2, &x7); \
+    *res = x7
+#define _PLAIN_POW_CHAIN_8(tp, mul) \
+    tp x2, x4, x8; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x4, &x8); \
+    *res = x8
+#define _PLAIN_POW_CHAIN_9(tp, mul) \
+    tp x2, x4, x8, x9; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x4, &x8); \
+    overflow |= mul(x8, x, &x9); \
+    *res = x9
+#define _PLAIN_POW_CHAIN_10(tp, mul) \
+    tp x2, x4, x5, x10; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x, &x5); \
+    overflow |= mul(x5, x5, &x10); \
+    *res = x10
+#define _PLAIN_POW_CHAIN_11(tp, mul) \
+    tp x2, x3, x5, x10, x11; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x2, &x5); \
+    overflow |= mul(x5, x5, &x10); \
+    overflow |= mul(x10, x, &x11); \
+    *res = x11
+#define _PLAIN_POW_CHAIN_12(tp, mul) \
+    tp x2, x3, x6, x12; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x3, &x6); \
+    overflow |= mul(x6, x6, &x12); \
+    *res = x12
+#define _PLAIN_POW_CHAIN_13(tp, mul) \
+    tp x2, x3, x5, x10, x13; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x2, &x5); \
+    overflow |= mul(x5, x5, &x10); \
+    overflow |= mul(x10, x3, &x13); \
+    *res = x13
+#define _PLAIN_POW_CHAIN_14(tp, mul) \
+    tp x2, x3, x5, x7, x14; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x2, &x5); \
+    overflow |= mul(x5, x2, &x7); \
+    overflow |= mul(x7, x7, &x14); \
+    *res = x14
+#define _PLAIN_POW_CHAIN_15(tp, mul) \
+    tp x2, x3, x6, x12, x15; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x, &x3); \
+    overflow |= mul(x3, x3, &x6); \
+    overflow |= mul(x6, x6, &x12); \
+    overflow |= mul(x12, x3, &x15); \
+    *res = x15
+#define _PLAIN_POW_CHAIN_16(tp, mul) \
+    tp x2, x4, x8, x16; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x4, &x8); \
+    overflow |= mul(x8, x8, &x16); \
+    *res = x16
+#define _PLAIN_POW_CHAIN_17(tp, mul) \
+    tp x2, x4, x8, x16, x17; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x4, &x8); \
+    overflow |= mul(x8, x8, &x16); \
+    overflow |= mul(x16, x, &x17); \
+    *res = x17
+#define _PLAIN_POW_CHAIN_18(tp, mul) \
+    tp x2, x4, x8, x9, x18; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x4, &x8); \
+    overflow |= mul(x8, x, &x9); \
+    overflow |= mul(x9, x9, &x18); \
+    *res = x18
+#define _PLAIN_POW_CHAIN_19(tp, mul) \
+    tp x2, x4, x8, x9, x18, x19; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x4, &x8); \
+    overflow |= mul(x8, x, &x9); \
+    overflow |= mul(x9, x9, &x18); \
+    overflow |= mul(x18, x, &x19); \
+    *res = x19
+#define _PLAIN_POW_CHAIN_20(tp, mul) \
+    tp x2, x4, x5, x10, x20; \
+    overflow |= mul(x, x, &x2); \
+    overflow |= mul(x2, x2, &x4); \
+    overflow |= mul(x4, x, &x5); \
+    overflow |= mul(x5, x5, &x10); \
+    overflow |= mul(x10, x10, &x20); \
+    *res = x20
+
+#define _PLAIN_IMPL_POW_CHAIN(tp, suffix, n) \
+    static inline bool _plain_int_pow ## suffix ## _chain_ ## n(tp x, tp *res) { \
+        bool overflow = false; \
+        _PLAIN_POW_CHAIN_ ## n(tp, plain_int_overflowing_mul ## suffix); \
+        return overflow; \
+    }
+
+#define _PLAIN_POW_CHAIN_0(tp, mul) (void) x; *res = 1
+#define _PLAIN_POW_CHAIN_1(tp, mul) *res = x
+
+#define _PLAIN_IMPL_POW_CHAINS(tp, suffix) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 0) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 1) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 2) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 3) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 4) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 5) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 6) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 7) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 8) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 9) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 10) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 11) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 12) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 13) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 14) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 15) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 16) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 17) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 18) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 19) \
+    _PLAIN_IMPL_POW_CHAIN(tp, suffix, 20)
+
+_PLAIN_IMPL_POW_CHAINS(int32_t, 32s)
+_PLAIN_IMPL_POW_CHAINS(uint32_t, 32u)
+_PLAIN_IMPL_POW_CHAINS(int64_t, 64s)
+_PLAIN_IMPL_POW_CHAINS(uint64_t, 64u)
+
+#undef _PLAIN_IMPL_POW_CHAINS
+#undef _PLAIN_IMPL_POW_CHAIN
+
+// Extra level of indirection to expand the exponent before pasting
+#define _PLAIN_POW_CHAIN_CALL(suffix, exp, base, res) _PLAIN_POW_CHAIN_PASTE(suffix, exp, base, res)
+#define _PLAIN_POW_CHAIN_PASTE(suffix, exp, base, res) _plain_int_pow ## suffix ## _chain_ ## exp(base, res)
+
+/**
+ * Raises `base` to a constant power, using a fixed sequence of multiplications.
+ *
+ * Returns true if overflow occurred, just like plain_int_pow32s_overflowing.
+ * The exponent must be an integer literal from 0 to 20.
+ */
+#define PLAIN_INT_POW32S_OVERFLOWING_CONST(base, exp, res) _PLAIN_POW_CHAIN_CALL(32s, exp, base, res)
+
+/**
+ * Raises `base` to a constant power, using a fixed sequence of multiplications.
+ *
+ * Returns true if overflow occurred, just like plain_int_pow32u_overflowing.
+ * The exponent must be an integer literal from 0 to 20.
+ */
+#define PLAIN_INT_POW32U_OVERFLOWING_CONST(base, exp, res) _PLAIN_POW_CHAIN_CALL(32u, exp, base, res)
+
+/**
+ * Raises `base` to a constant power, using a fixed sequence of multiplications.
+ *
+ * Returns true if overflow occurred, just like plain_int_pow64s_overflowing.
+ * The exponent must be an integer literal from 0 to 20.
+ */
+#define PLAIN_INT_POW64S_OVERFLOWING_CONST(base, exp, res) _PLAIN_POW_CHAIN_CALL(64s, exp, base, res)
+
+/**
+ * Raises `base` to a constant power, using a fixed sequence of multiplications.
+ *
+ * Returns true if overflow occurred, just like plain_int_pow64u_overflowing.
+ * The exponent must be an integer literal from 0 to 20.
+ */
+#define PLAIN_INT_POW64U_OVERFLOWING_CONST(base, exp, res) _PLAIN_POW_CHAIN_CALL(64u, exp, base, res)
+
+/*
+ * Checked arithmetic with a "sticky" overflow flag.
+ *
+ * This is the same trick used by exponentation by squaring (above):
+ * Instead of branching after every operation, OR the overflow flags together
+ * and check them once at the end.
+ *
+ * For example:
+ *     struct plain_int_checked ctx = PLAIN_INT_CHECKED_INIT;
+ *     uint64_t header_size = plain_int_checked_mul64u(&ctx, num_fields, sizeof(struct field));
+ *     uint64_t total = plain_int_checked_add64u(&ctx, header_size, payload_len);
+ *     if (ctx.overflowed) return ERROR_TOO_LARGE;
+ *
+ * Once overflow occurs, the flag stays set (and all the later results are meaningless).
+ * The results are computed using twos complement wrapping, like the overflowing_* functions
+ * (except for pow, see below).
+ *
+ * As long as the context is a local variable and everything is inlined,
+ * the compiler keeps the flag in a register.
+ */
+struct plain_int_checked {
+    /**
+     * If any operation has overflowed so far.
+     */
+    bool overflowed;
+};
+
+/**
+ * Initializes a `struct plain_int_checked` with no overflow.
+ */
+#define PLAIN_INT_CHECKED_INIT {false}
+
+#define _PLAIN_IMPL_CHECKED_OP(tp, op, suffix) \
+    static inline tp plain_int_checked_ ## op ## suffix(struct plain_int_checked *ctx, tp first, tp second) { \
+        tp res; \
+        ctx->overflowed |= plain_int_overflowing_ ## op ## suffix(first, second, &res); \
+        return res; \
+    }
+
+#define _PLAIN_IMPL_CHECKED_OPS(tp, suffix) \
+    _PLAIN_IMPL_CHECKED_OP(tp, add, suffix) \
+    _PLAIN_IMPL_CHECKED_OP(tp, sub, suffix) \
+    _PLAIN_IMPL_CHECKED_OP(tp, mul, suffix)
+
+/*
+ * Defines plain_int_checked_{add,sub,mul}{32,64}{s,u}
+ *
+ * Each of these takes the context as the first argument,
+ * and returns the (wrapped) result of the corresponding overflowing operation.
+ */
+_PLAIN_IMPL_CHECKED_OPS(int32_t, 32s)
+_PLAIN_IMPL_CHECKED_OPS(uint32_t, 32u)
+_PLAIN_IMPL_CHECKED_OPS(int64_t, 64s)
+_PLAIN_IMPL_CHECKED_OPS(uint64_t, 64u)
+
+#undef _PLAIN_IMPL_CHECKED_OPS
+#undef _PLAIN_IMPL_CHECKED_OP
+
+#define _PLAIN_IMPL_CHECKED_POW(tp, suffix) \
+    static inline tp plain_int_checked_pow ## suffix(struct plain_int_checked *ctx, tp base, uint32_t exp) { \
+        if (!_plain_int_pow ## suffix ## _fits(base, exp)) { \
+            ctx->overflowed = true; \
+            return 0; \
+        } \
+        return plain_int_pow ## suffix ## _wrapping(base, exp); \
+    }
+
+/*
+ * Defines plain_int_checked_pow{32,64}{s,u}
+ *
+ * Each of these raises `base` to the power of `exp`, marking the context if overflow occurs.
+ *
+ * Unlike the other checked operations, the result is zero if this overflows (not the wrapped result).
+ * That way, overflow is detected without running the loop at all.
+ */
+_PLAIN_IMPL_CHECKED_POW(int32_t, 32s)
+_PLAIN_IMPL_CHECKED_POW(uint32_t, 32u)
+_PLAIN_IMPL_CHECKED_POW(int64_t, 64s)
+_PLAIN_IMPL_CHECKED_POW(uint64_t, 64u)
+
+#undef _PLAIN_IMPL_CHECKED_POW
+
+/*
+ * Division by invariant integers
+ *
+ * A hardware division costs around 20-90 cycles (depending on the width & CPU),
+ * but when the same divisor is used over and over it can be replaced by
+ * a multiplication with a precomputed "magic number" and a shift.
+ * This is what compilers already do when the divisor is a constant.
+ *
+ * For example:
+ *     struct plain_int_divider32u buckets = plain_int_divider32u_new(num_buckets);
+ *     for (size_t i = 0; i < n; i++) {
+ *         counts[plain_int_divider32u_mod(&buckets, hashes[i])] += 1;
+ *     }
+ *
+ * The magic number is `ceil(2^(N + shift) / divisor)`, where N is the width of the type.
+ * Sometimes this needs N + 1 bits, in which case the extra bit is handled
+ * by adding the numerator back in (the `add` flag).
+ * Powers of two are just a shift, and are marked by a magic number of zero.
+ * See Hacker's Delight chapter 10 "Integer Division by Constants"
+ * (and Granlund & Montgomery "Division by Invariant Integers using Multiplication").
+ *
+ * Divisibility is checked without computing the quotient (Hacker's Delight 10-17).
+ * If the divisor is `d * 2^k` where `d` is odd, then `n` is divisible
+ * exactly when `rotr(n * inverse(d), k) <= MAX / divisor`.
+ *
+ * Signed division rounds towards zero, just like the `/` operator.
+ * Dividing the minimum value by -1 wraps around (instead of being undefined behavior).
+ *
+ * Computing the divider still takes a hardware division,
+ * so it only pays off if the divider is used more than a couple times.
+ */
+
+/**
+ * Precomputed constants for dividing by an unsigned 32-bit integer.
+ *
+ * Created by plain_int_divider32u_new
+ */
+struct plain_int_divider32u {
+    /**
+     * The original divisor.
+     */
+    uint32_t divisor;
+    /**
+     * The magic number to multiply by (or zero if the divisor is a power of two).
+     */
+    uint32_t magic;
+    /**
+     * The inverse of the odd part of the divisor, modulo 2^32.
+     */
+    uint32_t inverse;
+    /**
+     * The largest possible quotient, `UINT32_MAX / divisor`.
+     */
+    uint32_t max_quotient;
+    /**
+     * The amount to shift the high half of the product by.
+     */
+    uint8_t shift;
+    /**
+     * The number of trailing zeros in the divisor.
+     */
+    uint8_t trailing_zeros;
+    /**
+     * If the magic number has an implicit 33rd bit.
+     */
+    bool add;
+};
+
+/**
+ * Precomputed constants for dividing by an unsigned 64-bit integer.
+ *
+ * Created by plain_int_divider64u_new
+ */
+struct plain_int_divider64u {
+    /**
+     * The original divisor.
+     */
+    uint64_t divisor;
+    /**
+     * The magic number to multiply by (or zero if the divisor is a power of two).
+     */
+    uint64_t magic;
+    /**
+     * The inverse of the odd part of the divisor, modulo 2^64.
+     */
+    uint64_t inverse;
+    /**
+     * The largest possible quotient, `UINT64_MAX / divisor`.
+     */
+    uint64_t max_quotient;
+    /**
+     * The amount to shift the high half of the product by.
+     */
+    uint8_t shift;
+    /**
+     * The number of trailing zeros in the divisor.
+     */
+    uint8_t trailing_zeros;
+    /**
+     * If the magic number has an implicit 65th bit.
+     */
+    bool add;
+};
+
+/**
+ * Precomputed constants for dividing by a signed 32-bit integer.
+ *
+ * Created by plain_int_divider32s_new
+ */
+struct plain_int_divider32s {
+    /**
+     * The original divisor.
+     */
+    int32_t divisor;
+    /**
+     * The magic number to multiply by (or zero if the divisor is a power of two, or its negation).
+     *
+     * This is negated for negative divisors.
+     */
+    int32_t magic;
+    /**
+     * The inverse of the odd part of the divisor's magnitude, modulo 2^32.
+     */
+    uint32_t inverse;
+    /**
+     * The largest possible magnitude of the quotient, `UINT32_MAX / abs(divisor)`.
+     */
+    uint32_t max_quotient;
+    /**
+     * The amount to shift the high half of the product by.
+     */
+    uint8_t shift;
+    /**
+     * The number of trailing zeros in the divisor.
+     */
+    uint8_t trailing_zeros;
+    /**
+     * If the numerator needs to be added to the product (or subtracted for negative divisors).
+     */
+    bool add;
+    /**
+     * If the divisor is negative.
+     */
+    bool negative;
+};
+
+/**
+ * Precomputed constants for dividing by a signed 64-bit integer.
+ *
+ * Created by plain_int_divider64s_new
+ */
+struct plain_int_divider64s {
+    /**
+     * The original divisor.
+     */
+    int64_t divisor;
+    /**
+     * The magic number to multiply by (or zero if the divisor is a power of two, or its negation).
+     *
+     * This is negated for negative divisors.
+     */
+    int64_t magic;
+    /**
+     * The inverse of the odd part of the divisor's magnitude, modulo 2^64.
+     */
+    uint64_t inverse;
+    /**
+     * The largest possible magnitude of the quotient, `UINT64_MAX / abs(divisor)`.
+     */
+    uint64_t max_quotient;
+    /**
+     * The amount to shift the high half of the product by.
+     */
+    uint8_t shift;
+    /**
+     * The number of trailing zeros in the divisor.
+     */
+    uint8_t trailing_zeros;
+    /**
+     * If the numerator needs to be added to the product (or subtracted for negative divisors).
+     */
+    bool add;
+    /**
+     * If the divisor is negative.
+     */
+    bool negative;
+};
+
+static inline uint32_t _plain_int_mul_high32u(uint32_t first, uint32_t second) {
+    return (uint32_t) ((((uint64_t) first) * second) >> 32);
+}
+
+static inline int32_t _plain_int_mul_high32s(int32_t first, int32_t second) {
+    return (int32_t) ((((int64_t) first) * second) >> 32);
+}
+
+/*
+ * The multiplicative inverse of an odd number, modulo 2^32.
+ *
+ * Uses Newton's method, where each step doubles the number of correct bits.
+ * Every odd number is its own inverse modulo 8, so it starts with three.
+ */
+static inline uint32_t _plain_int_inverse32u(uint32_t odd) {
+    assert((odd & 1) != 0);
+    uint32_t inverse = odd;
+    for (int i = 0; i < 4; i++) {
+        inverse *= 2 - odd * inverse;
+    }
+    return inverse;
+}
+
+/*
+ * The multiplicative inverse of an odd number, modulo 2^64.
+ */
+static inline uint64_t _plain_int_inverse64u(uint64_t odd) {
+    assert((odd & 1) != 0);
+    uint64_t inverse = odd;
+    for (int i = 0; i < 5; i++) {
+        inverse *= 2 - odd * inverse;
+    }
+    return inverse;
+}
+
+/*
+ * Divides the 128 bit value `high * 2^64 + low` by the divisor,
+ * which must be greater than `high` (so the quotient fits in 64 bits).
+ *
+ * The fallback is Knuth's Algorithm D, using 32 bit digits.
+ * See Hacker's Delight 9-4 "Unsigned Long Division" (divlu).
+ */
+static inline uint64_t _plain_int_div128by64(uint64_t high, uint64_t low, uint64_t divisor, uint64_t *rem) {
+    assert(high < divisor);
+#if defined(_PLAIN_INT_GNU_BUILTINS) && defined(__SIZEOF_INT128__)
+    _plain_int_u128 numerator = (((_plain_int_u128) high) << 64) | low;
+    *rem = (uint64_t) (numerator % divisor);
+    return (uint64_t) (numerator / divisor);
+#elif defined(_PLAIN_INT_MSVC_INTRINSICS) && defined(_M_X64) && _MSC_VER >= 1920
+    return _udiv128(high, low, divisor, rem);
+#else
+    const uint64_t base = UINT64_C(1) << 32;
+    // Normalize so the top bit of the divisor is set
+    int shift = plain_int_nlz64(divisor);
+    divisor <<= shift;
+    uint64_t divisor_hi = divisor >> 32, divisor_lo = divisor & UINT32_MAX;
+    uint64_t num_32 = shift == 0 ? high : (high << shift) | (low >> (64 - shift));
+    uint64_t num_10 = low << shift;
+    uint64_t num_1 = num_10 >> 32, num_0 = num_10 & UINT32_MAX;
+    // Estimate each quotient digit from the top digit of the divisor, then correct it (at most twice)
+    uint64_t q1 = num_32 / divisor_hi;
+    uint64_t rhat = num_32 - q1 * divisor_hi;
+    while (q1 >= base || q1 * divisor_lo > base * rhat + num_1) {
+        q1 -= 1;
+        rhat += divisor_hi;
+        if (rhat >= base) break;
+    }
+    uint64_t num_21 = num_32 * base + num_1 - q1 * divisor;
+    uint64_t q0 = num_21 / divisor_hi;
+    rhat = num_21 - q0 * divisor_hi;
+    while (q0 >= base || q0 * divisor_lo > base * rhat + num_0) {
+        q0 -= 1;
+        rhat += divisor_hi;
+        if (rhat >= base) break;
+    }
+    *rem = (num_21 * base + num_0 - q0 * divisor) >> shift;
+    return q1 * base + q0;
+#endif
+}
+
+/**
+ * Precomputes the constants for dividing by the specified (nonzero) divisor.
+ */
+static inline struct plain_int_divider32u plain_int_divider32u_new(uint32_t divisor) {
+    assert(divisor != 0);
+    struct plain_int_divider32u res;
+    int log2 = plain_int_ilog2_32u(divisor);
+    res.divisor = divisor;
+    res.trailing_zeros = (uint8_t) plain_int_ntz32(divisor);
+    res.inverse = _plain_int_inverse32u(divisor >> res.trailing_zeros);
+    res.max_quotient = UINT32_MAX / divisor;
+    res.shift = (uint8_t) log2;
+    res.add = false;
+    if ((divisor & (divisor - 1)) == 0) {
+        res.magic = 0;
+        return res;
+    }
+    uint64_t numerator = UINT64_C(1) << (32 + log2);
+    uint32_t magic = (uint32_t) (numerator / divisor);
+    uint32_t rem = (uint32_t) (numerator % divisor);
+    if (divisor - rem < (UINT32_C(1) << log2)) {
+        // Rounding up to 32 bits is accurate enough for every numerator
+        res.magic = magic + 1;
+    } else {
+        // Use 2^(33 + log2) / divisor instead, with the top bit implicit
+        uint32_t twice_rem = rem + rem;
+        magic += magic;
+        if (twice_rem >= divisor || twice_rem < rem) magic += 1;
+        res.magic = magic + 1;
+        res.add = true;
+    }
+    return res;
+}
+
+/**
+ * Precomputes the constants for dividing by the specified (nonzero) divisor.
+ */
+static inline struct plain_int_divider64u plain_int_divider64u_new(uint64_t divisor) {
+    assert(divisor != 0);
+    struct plain_int_divider64u res;
+    int log2 = plain_int_ilog2_64u(divisor);
+    res.divisor = divisor;
+    res.trailing_zeros = (uint8_t) plain_int_ntz64(divisor);
+    res.inverse = _plain_int_inverse64u(divisor >> res.trailing_zeros);
+    res.max_quotient = UINT64_MAX / divisor;
+    res.shift = (uint8_t) log2;
+    res.add = false;
+    if ((divisor & (divisor - 1)) == 0) {
+        res.magic = 0;
+        return res;
+    }
+    uint64_t rem;
+    uint64_t magic = _plain_int_div128by64(UINT64_C(1) << log2, 0, divisor, &rem);
+    if (divisor - rem < (UINT64_C(1) << log2)) {
+        // Rounding up to 64 bits is accurate enough for every numerator
+        res.magic = magic + 1;
+    } else {
+        // Use 2^(65 + log2) / divisor instead, with the top bit implicit
+        uint64_t twice_rem = rem + rem;
+        magic += magic;
+        if (twice_rem >= divisor || twice_rem < rem) magic += 1;
+        res.magic = magic + 1;
+        res.add = true;
+    }
+    return res;
+}
+
+/**
+ * Precomputes the constants for dividing by the specified (nonzero) divisor.
+ */
+static inline struct plain_int_divider32s plain_int_divider32s_new(int32_t divisor) {
+    assert(divisor != 0);
+    struct plain_int_divider32s res;
+    uint32_t abs_divisor = divisor < 0 ? 0u - (uint32_t) divisor : (uint32_t) divisor;
+    int log2 = plain_int_ilog2_32u(abs_divisor);
+    res.divisor = divisor;
+    res.negative = divisor < 0;
+    res.trailing_zeros = (uint8_t) plain_int_ntz32(abs_divisor);
+    res.inverse = _plain_int_inverse32u(abs_divisor >> res.trailing_zeros);
+    res.max_quotient = UINT32_MAX / abs_divisor;
+    res.shift = (uint8_t) log2;
+    res.add = false;
+    if ((abs_divisor & (abs_divisor - 1)) == 0) {
+        res.magic = 0;
+        return res;
+    }
+    // The quotient only has 31 bits of magnitude, so this needs one less bit of precision
+    uint64_t numerator = UINT64_C(1) << (31 + log2);
+    uint32_t magic = (uint32_t) (numerator / abs_divisor);
+    uint32_t rem = (uint32_t) (numerator % abs_divisor);
+    if (abs_divisor - rem < (UINT32_C(1) << log2)) {
+        res.shift = (uint8_t) (log2 - 1);
+    } else {
+        uint32_t twice_rem = rem + rem;
+        magic += magic;
+        if (twice_rem >= abs_divisor || twice_rem < rem) magic += 1;
+        res.add = true;
+    }
+    magic += 1;
+    // Negating the magic number negates the quotient
+    res.magic = (int32_t) (res.negative ? 0u - magic : magic);
     return res;
 }
 
+/**
+ * Precomputes the constants for dividing by the specified (nonzero) divisor.
+ */
+static inline struct plain_int_divider64s plain_int_divider64s_new(int64_t divisor) {
+    assert(divisor != 0);
+    struct plain_int_divider64s res;
+    uint64_t abs_divisor = divisor < 0 ? 0u - (uint64_t) divisor : (uint64_t) divisor;
+    int log2 = plain_int_ilog2_64u(abs_divisor);
+    res.divisor = divisor;
+    res.negative = divisor < 0;
+    res.trailing_zeros = (uint8_t) plain_int_ntz64(abs_divisor);
+    res.inverse = _plain_int_inverse64u(abs_divisor >> res.trailing_zeros);
+    res.max_quotient = UINT64_MAX / abs_divisor;
+    res.shift = (uint8_t) log2;
+    res.add = false;
+    if ((abs_divisor & (abs_divisor - 1)) == 0) {
+        res.magic = 0;
+        return res;
+    }
+    // The quotient only has 63 bits of magnitude, so this needs one less bit of precision
+    uint64_t rem;
+    uint64_t magic = _plain_int_div128by64(UINT64_C(1) << (log2 - 1), 0, abs_divisor, &rem);
+    if (abs_divisor - rem < (UINT64_C(1) << log2)) {
+        res.shift = (uint8_t) (log2 - 1);
+    } else {
+        uint64_t twice_rem = rem + rem;
+        magic += magic;
+        if (twice_rem >= abs_divisor || twice_rem < rem) magic += 1;
+        res.add = true;
+    }
+    magic += 1;
+    // Negating the magic number negates the quotient
+    res.magic = (int64_t) (res.negative ? 0u - magic : magic);
+    return res;
+}
+
+#define _PLAIN_IMPL_DIVIDER_UNSIGNED(bits) \
+    static inline uint ## bits ## _t plain_int_divider ## bits ## u_div( \
+        const struct plain_int_divider ## bits ## u *divider, \
+        uint ## bits ## _t val \
+    ) { \
+        if (divider->magic == 0) return val >> divider->shift; \
+        uint ## bits ## _t high = _PLAIN_DIVIDER_MUL_HIGH ## bits ## U(divider->magic, val); \
+        if (divider->add) { \
+            /* (val + high) >> 1, without overflowing */ \
+            return (((val - high) >> 1) + high) >> divider->shift; \
+        } else { \
+            return high >> divider->shift; \
+        } \
+    } \
+    static inline uint ## bits ## _t plain_int_divider ## bits ## u_mod( \
+        const struct plain_int_divider ## bits ## u *divider, \
+        uint ## bits ## _t val \
+    ) { \
+        return val - plain_int_divider ## bits ## u_div(divider, val) * divider->divisor; \
+    } \
+    static inline bool plain_int_divider ## bits ## u_divisible( \
+        const struct plain_int_divider ## bits ## u *divider, \
+        uint ## bits ## _t val \
+    ) { \
+        return plain_int_rotr ## bits(val * divider->inverse, divider->trailing_zeros) \
+            <= divider->max_quotient; \
+    }
+
+#define _PLAIN_IMPL_DIVIDER_SIGNED(bits) \
+    static inline int ## bits ## _t plain_int_divider ## bits ## s_div( \
+        const struct plain_int_divider ## bits ## s *divider, \
+        int ## bits ## _t val \
+    ) { \
+        int ## bits ## _t quotient; \
+        if (divider->magic == 0) { \
+            /* Add (2^shift - 1) to negative values, so the shift rounds towards zero */ \
+            uint ## bits ## _t mask = (((uint ## bits ## _t) 1) << divider->shift) - 1; \
+            uint ## bits ## _t bias = ((uint ## bits ## _t) (val >> (bits - 1))) & mask; \
+            quotient = ((int ## bits ## _t) ((uint ## bits ## _t) val + bias)) >> divider->shift; \
+            if (divider->negative) quotient = (int ## bits ## _t) (0u - (uint ## bits ## _t) quotient); \
+            return quotient; \
+        } \
+        uint ## bits ## _t high = (uint ## bits ## _t) _PLAIN_DIVIDER_MUL_HIGH ## bits ## S(divider->magic, val); \
+        if (divider->add) { \
+            high += divider->negative ? 0u - (uint ## bits ## _t) val : (uint ## bits ## _t) val; \
+        } \
+        quotient = ((int ## bits ## _t) high) >> divider->shift; \
+        /* Round towards zero instead of down */ \
+        return quotient + (quotient < 0); \
+    } \
+    static inline int ## bits ## _t plain_int_divider ## bits ## s_mod( \
+        const struct plain_int_divider ## bits ## s *divider, \
+        int ## bits ## _t val \
+    ) { \
+        /* Unsigned, so MIN % -1 doesn't overflow */ \
+        uint ## bits ## _t quotient = (uint ## bits ## _t) plain_int_divider ## bits ## s_div(divider, val); \
+        return (int ## bits ## _t) ((uint ## bits ## _t) val - quotient * (uint ## bits ## _t) divider->divisor); \
+    } \
+    static inline bool plain_int_divider ## bits ## s_divisible( \
+        const struct plain_int_divider ## bits ## s *divider, \
+        int ## bits ## _t val \
+    ) { \
+        uint ## bits ## _t magnitude = val < 0 ? 0u - (uint ## bits ## _t) val : (uint ## bits ## _t) val; \
+        return plain_int_rotr ## bits(magnitude * divider->inverse, divider->trailing_zeros) \
+            <= divider->max_quotient; \
+    }
+
+/*
+ * The batch versions check the flags once, outside of the loops.
+ *
+ * That leaves loops without any branches, which the compiler can unroll (and sometimes vectorize).
+ * The remainder is computed from blocks of quotients, so the output can be the same array as the input.
+ */
+#define _PLAIN_DIVIDER_BATCH_BLOCK 256
+
+#define _PLAIN_IMPL_DIVIDER_UNSIGNED_BATCH(bits) \
+    static inline void plain_int_divider ## bits ## u_div_batch( \
+        const struct plain_int_divider ## bits ## u *divider, \
+        const uint ## bits ## _t *values, \
+        uint ## bits ## _t *out, \
+        size_t n \
+    ) { \
+        const uint ## bits ## _t magic = divider->magic; \
+        const unsigned int shift = divider->shift; \
+        if (magic == 0) { \
+            for (size_t i = 0; i < n; i++) { \
+                out[i] = values[i] >> shift; \
+            } \
+        } else if (divider->add) { \
+            for (size_t i = 0; i < n; i++) { \
+                uint ## bits ## _t val = values[i]; \
+                uint ## bits ## _t high = _PLAIN_DIVIDER_MUL_HIGH ## bits ## U(magic, val); \
+                out[i] = (((val - high) >> 1) + high) >> shift; \
+            } \
+        } else { \
+            for (size_t i = 0; i < n; i++) { \
+                out[i] = _PLAIN_DIVIDER_MUL_HIGH ## bits ## U(magic, values[i]) >> shift; \
+            } \
+        } \
+    } \
+    _PLAIN_IMPL_DIVIDER_MOD_BATCH(uint ## bits ## _t, bits ## u)
+
+#define _PLAIN_IMPL_DIVIDER_SIGNED_BATCH(bits) \
+    static inline void plain_int_divider ## bits ## s_div_batch( \
+        const struct plain_int_divider ## bits ## s *divider, \
+        const int ## bits ## _t *values, \
+        int ## bits ## _t *out, \
+        size_t n \
+    ) { \
+        const int ## bits ## _t magic = divider->magic; \
+        const unsigned int shift = divider->shift; \
+        /* All ones if the divisor is negative, for negating with (x ^ sign) - sign */ \
+        const uint ## bits ## _t sign = divider->negative ? ~((uint ## bits ## _t) 0) : 0; \
+        if (magic == 0) { \
+            const uint ## bits ## _t mask = (((uint ## bits ## _t) 1) << shift) - 1; \
+            for (size_t i = 0; i < n; i++) { \
+                int ## bits ## _t val = values[i]; \
+                uint ## bits ## _t bias = ((uint ## bits ## _t) (val >> (bits - 1))) & mask; \
+                uint ## bits ## _t quotient = (uint ## bits ## _t) \
+                    (((int ## bits ## _t) ((uint ## bits ## _t) val + bias)) >> shift); \
+                out[i] = (int ## bits ## _t) ((quotient ^ sign) - sign); \
+            } \
+        } else { \
+            const uint ## bits ## _t add_mask = divider->add ? ~((uint ## bits ## _t) 0) : 0; \
+            for (size_t i = 0; i < n; i++) { \
+                int ## bits ## _t val = values[i]; \
+                uint ## bits ## _t high = (uint ## bits ## _t) _PLAIN_DIVIDER_MUL_HIGH ## bits ## S(magic, val); \
+                high += ((((uint ## bits ## _t) val) ^ sign) - sign) & add_mask; \
+                int ## bits ## _t quotient = ((int ## bits ## _t) high) >> shift; \
+                out[i] = quotient + (quotient < 0); \
+            } \
+        } \
+    } \
+    _PLAIN_IMPL_DIVIDER_MOD_BATCH(int ## bits ## _t, bits ## s)
+
+#define _PLAIN_IMPL_DIVIDER_MOD_BATCH(tp, suffix) \
+    static inline void plain_int_divider ## suffix ## _mod_batch( \
+        const struct plain_int_divider ## suffix *divider, \
+        const tp *values, \
+        tp *out, \
+        size_t n \
+    ) { \
+        tp quotients[_PLAIN_DIVIDER_BATCH_BLOCK]; \
+        for (size_t start = 0; start < n; start += _PLAIN_DIVIDER_BATCH_BLOCK) { \
+            size_t len = n - start < _PLAIN_DIVIDER_BATCH_BLOCK ? n - start : _PLAIN_DIVIDER_BATCH_BLOCK; \
+            plain_int_divider ## suffix ## _div_batch(divider, values + start, quotients, len); \
+            for (size_t i = 0; i < len; i++) { \
+                /* Unsigned, so MIN % -1 doesn't overflow */ \
+                out[start + i] = (tp) ((uint64_t) values[start + i] \
+                    - (uint64_t) quotients[i] * (uint64_t) divider->divisor); \
+            } \
+        } \
+    }
+
+#define _PLAIN_DIVIDER_MUL_HIGH32U _plain_int_mul_high32u
+#define _PLAIN_DIVIDER_MUL_HIGH64U plain_int_mul_high64u
+#define _PLAIN_DIVIDER_MUL_HIGH32S _plain_int_mul_high32s
+#define _PLAIN_DIVIDER_MUL_HIGH64S plain_int_mul_high64s
+
+/*
+ * Defines plain_int_divider{32,64}{s,u}_{div,mod,divisible}
+ *
+ * Each of these takes a pointer to the divider, and gives the same result as
+ * the `/` operator, the `%` operator, and `val % divisor == 0` respectively.
+ */
+_PLAIN_IMPL_DIVIDER_UNSIGNED(32)
+_PLAIN_IMPL_DIVIDER_UNSIGNED(64)
+_PLAIN_IMPL_DIVIDER_SIGNED(32)
+_PLAIN_IMPL_DIVIDER_SIGNED(64)
+
+/*
+ * Defines plain_int_divider{32,64}{s,u}_{div,mod}_batch
+ *
+ * Each of these divides an array of `n` values, writing the results to `out`.
+ * The output may be the same array as the input.
+ */
+_PLAIN_IMPL_DIVIDER_UNSIGNED_BATCH(32)
+_PLAIN_IMPL_DIVIDER_UNSIGNED_BATCH(64)
+_PLAIN_IMPL_DIVIDER_SIGNED_BATCH(32)
+_PLAIN_IMPL_DIVIDER_SIGNED_BATCH(64)
+
+#undef _PLAIN_IMPL_DIVIDER_UNSIGNED
+#undef _PLAIN_IMPL_DIVIDER_SIGNED
+#undef _PLAIN_IMPL_DIVIDER_UNSIGNED_BATCH
+#undef _PLAIN_IMPL_DIVIDER_SIGNED_BATCH
+#undef _PLAIN_IMPL_DIVIDER_MOD_BATCH
+#undef _PLAIN_DIVIDER_BATCH_BLOCK
+#undef _PLAIN_DIVIDER_MUL_HIGH32U
+#undef _PLAIN_DIVIDER_MUL_HIGH64U
+#undef _PLAIN_DIVIDER_MUL_HIGH32S
+#undef _PLAIN_DIVIDER_MUL_HIGH64S
+
+/*
+ * Multiply then divide (without overflowing in between)
+ *
+ * Computing `a * b / c` directly overflows whenever the product doesn't fit in 64 bits,
+ * even if the final result does (for example, converting a tick count to nanoseconds).
+ * These keep the full 128 bit product, and only fail if the final result doesn't fit.
+ *
+ * The fixed-point helpers are the same thing, dividing by a power of two.
+ * A Qm.n number stores `x` as the integer `x * 2^n` (for example, Q16.16 has 16 fractional bits),
+ * so multiplying two of them needs the product shifted right by `n` bits.
+ *
+ * Just like the other overflowing functions, these return true if overflow occurred.
+ * In that case the result wraps around (it is the low bits of the exact result).
+ */
+
+/**
+ * How to round the result of a division.
+ */
+enum plain_int_rounding {
+    /**
+     * Round towards zero, just like the `/` operator.
+     */
+    PLAIN_INT_ROUND_TOWARD_ZERO,
+    /**
+     * Round down, towards negative infinity (the floor).
+     */
+    PLAIN_INT_ROUND_DOWN,
+    /**
+     * Round up, towards positive infinity (the ceiling).
+     */
+    PLAIN_INT_ROUND_UP,
+    /**
+     * Round to the nearest integer, with ties going away from zero.
+     */
+    PLAIN_INT_ROUND_NEAREST,
+};
+
+/*
+ * Rounds a 128 bit quotient, given the remainder from dividing by `divisor`.
+ *
+ * The quotient & remainder are magnitudes, so `negative` gives the sign of the exact result.
+ */
+static inline void _plain_int_round_quotient(
+    uint64_t *quotient_high,
+    uint64_t *quotient_low,
+    uint64_t rem,
+    uint64_t divisor,
+    bool negative,
+    enum plain_int_rounding rounding
+) {
+    bool increment;
+    switch (rounding) {
+        case PLAIN_INT_ROUND_TOWARD_ZERO:
+            increment = false;
+            break;
+        case PLAIN_INT_ROUND_DOWN:
+            increment = negative && rem != 0;
+            break;
+        case PLAIN_INT_ROUND_UP:
+            increment = !negative && rem != 0;
+            break;
+        case PLAIN_INT_ROUND_NEAREST:
+            // rem * 2 >= divisor, without overflowing
+            increment = rem >= divisor - rem;
+            break;
+        default:
+            assert(false);
+            increment = false;
+            break;
+    }
+    *quotient_low += increment;
+    *quotient_high += increment && *quotient_low == 0;
+}
+
+/*
+ * Gives the signed result with the specified magnitude, returning true if it overflows.
+ */
+static inline bool _plain_int_signed_from_magnitude(
+    uint64_t magnitude_high,
+    uint64_t magnitude_low,
+    bool negative,
+    int64_t *res
+) {
+    // The minimum value has one more unit of magnitude than the maximum
+    uint64_t limit = ((uint64_t) INT64_MAX) + negative;
+    *res = (int64_t) (negative ? 0 - magnitude_low : magnitude_low);
+    return magnitude_high != 0 || magnitude_low > limit;
+}
+
+/*
+ * Divides the 128 bit product of two magnitudes, giving a (rounded) 128 bit quotient.
+ */
+static inline uint64_t _plain_int_mul_div_magnitude(
+    uint64_t first,
+    uint64_t second,
+    uint64_t divisor,
+    bool negative,
+    enum plain_int_rounding rounding,
+    uint64_t *quotient_high
+) {
+    uint64_t high, rem, quotient_low;
+    uint64_t low = plain_int_mul_wide64u(first, second, &high);
+    if (high == 0) {
+        // The common case only needs a regular division
+        *quotient_high = 0;
+        quotient_low = low / divisor;
+        rem = low % divisor;
+    } else {
+        *quotient_high = high / divisor;
+        quotient_low = _plain_int_div128by64(high % divisor, low, divisor, &rem);
+    }
+    _plain_int_round_quotient(quotient_high, &quotient_low, rem, divisor, negative, rounding);
+    return quotient_low;
+}
+
+/**
+ * Computes `first * second / divisor` as if by infinite precision, then rounds it.
+ *
+ * Returns true if the result doesn't fit in 64 bits.
+ * The intermediate product never overflows.
+ *
+ * The divisor must not be zero.
+ */
+static inline bool plain_int_mul_div64u(
+    uint64_t first,
+    uint64_t second,
+    uint64_t divisor,
+    enum plain_int_rounding rounding,
+    uint64_t *res
+) {
+    assert(divisor != 0);
+    uint64_t quotient_high;
+    *res = _plain_int_mul_div_magnitude(first, second, divisor, false, rounding, &quotient_high);
+    return quotient_high != 0;
+}
+
+/**
+ * Computes `first * second / divisor` as if by infinite precision, then rounds it.
+ *
+ * Returns true if the result doesn't fit in 64 bits.
+ * The intermediate product never overflows.
+ *
+ * The divisor must not be zero.
+ */
+static inline bool plain_int_mul_div64s(
+    int64_t first,
+    int64_t second,
+    int64_t divisor,
+    enum plain_int_rounding rounding,
+    int64_t *res
+) {
+    assert(divisor != 0);
+    bool negative = ((first < 0) != (second < 0)) != (divisor < 0);
+    uint64_t quotient_high;
+    uint64_t quotient_low = _plain_int_mul_div_magnitude(
+        first < 0 ? 0 - (uint64_t) first : (uint64_t) first,
+        second < 0 ? 0 - (uint64_t) second : (uint64_t) second,
+        divisor < 0 ? 0 - (uint64_t) divisor : (uint64_t) divisor,
+        negative,
+        rounding,
+        &quotient_high
+    );
+    return _plain_int_signed_from_magnitude(quotient_high, quotient_low, negative, res);
+}
+
+/*
+ * Shifts the 128 bit product of two magnitudes right by `frac_bits`, giving a (rounded) 128 bit result.
+ */
+static inline uint64_t _plain_int_mul_q_magnitude(
+    uint64_t first,
+    uint64_t second,
+    unsigned int frac_bits,
+    bool negative,
+    enum plain_int_rounding rounding,
+    uint64_t *res_high
+) {
+    assert(frac_bits < 64);
+    uint64_t high;
+    uint64_t low = plain_int_mul_wide64u(first, second, &high);
+    uint64_t res_low = low;
+    *res_high = high;
+    if (frac_bits != 0) {
+        res_low = (low >> frac_bits) | (high << (64 - frac_bits));
+        *res_high = high >> frac_bits;
+    }
+    uint64_t rem = low & ((UINT64_C(1) << frac_bits) - 1);
+    _plain_int_round_quotient(res_high, &res_low, rem, UINT64_C(1) << frac_bits, negative, rounding);
+    return res_low;
+}
+
+/**
+ * Multiplies two unsigned fixed-point numbers with `frac_bits` fractional bits (UQm.n format).
+ *
+ * Returns true if the result doesn't fit in 64 bits.
+ * The fractional bits must be less than 64.
+ */
+static inline bool plain_int_mul_q64u(
+    uint64_t first,
+    uint64_t second,
+    unsigned int frac_bits,
+    enum plain_int_rounding rounding,
+    uint64_t *res
+) {
+    uint64_t res_high;
+    *res = _plain_int_mul_q_magnitude(first, second, frac_bits, false, rounding, &res_high);
+    return res_high != 0;
+}
+
+/**
+ * Multiplies two signed fixed-point numbers with `frac_bits` fractional bits (Qm.n format).
+ *
+ * Returns true if the result doesn't fit in 64 bits.
+ * The fractional bits must be less than 64.
+ */
+static inline bool plain_int_mul_q64s(
+    int64_t first,
+    int64_t second,
+    unsigned int frac_bits,
+    enum plain_int_rounding rounding,
+    int64_t *res
+) {
+    bool negative = (first < 0) != (second < 0);
+    uint64_t res_high;
+    uint64_t res_low = _plain_int_mul_q_magnitude(
+        first < 0 ? 0 - (uint64_t) first : (uint64_t) first,
+        second < 0 ? 0 - (uint64_t) second : (uint64_t) second,
+        frac_bits,
+        negative,
+        rounding,
+        &res_high
+    );
+    return _plain_int_signed_from_magnitude(res_high, res_low, negative, res);
+}
+
+/**
+ * Multiplies two unsigned fixed-point numbers with `frac_bits` fractional bits (UQm.n format).
+ *
+ * Returns true if the result doesn't fit in 32 bits.
+ * The fractional bits must be less than 32.
+ */
+static inline bool plain_int_mul_q32u(
+    uint32_t first,
+    uint32_t second,
+    unsigned int frac_bits,
+    enum plain_int_rounding rounding,
+    uint32_t *res
+) {
+    assert(frac_bits < 32);
+    // The 64 bit version can't overflow, since the product fits in 64 bits
+    uint64_t wide_res;
+    (void) plain_int_mul_q64u(first, second, frac_bits, rounding, &wide_res);
+    *res = (uint32_t) wide_res;
+    return wide_res > UINT32_MAX;
+}
+
+/**
+ * Multiplies two signed fixed-point numbers with `frac_bits` fractional bits (Qm.n format).
+ *
+ * Returns true if the result doesn't fit in 32 bits.
+ * The fractional bits must be less than 32.
+ */
+static inline bool plain_int_mul_q32s(
+    int32_t first,
+    int32_t second,
+    unsigned int frac_bits,
+    enum plain_int_rounding rounding,
+    int32_t *res
+) {
+    assert(frac_bits < 32);
+    // The 64 bit version can't overflow, since the product fits in 64 bits
+    int64_t wide_res;
+    (void) plain_int_mul_q64s(first, second, frac_bits, rounding, &wide_res);
+    *res = (int32_t) wide_res;
+    return wide_res < INT32_MIN || wide_res > INT32_MAX;
+}
+
 #endif /* PLAINLIBS_INTMATH_H */
@@ -0,0 +1,814 @@
+/**
+ * Overflow checked arithmetic over arrays of integers, using SIMD where possible.
+ *
+ * Requires "intbuiltins.h" (for the scalar versions and the leftover elements)
+ *
+ * The elementwise operations (add/sub/mul) compute `out[i] = first[i] op second[i]`
+ * using twos complement wrapping (just like the plain_int_overflowing_* functions),
+ * and return the index of the first element that overflowed (or `n` if none did).
+ * All the elements are computed regardless of overflow.
+ * The output may be the same array as one of the inputs, but must not partially overlap.
+ *
+ * The sums & dot products don't care about the order of operations:
+ * They only report overflow if the true (mathematical) result doesn't fit,
+ * even if some intermediate sum would have overflowed.
+ * Counting how many times each SIMD lane wraps around makes this exact.
+ *
+ * The instruction set is selected at compile time:
+ * - AVX2 (if `__AVX2__` is defined)
+ * - SSE4.2 (if `__SSE4_2__` or `__AVX__` is defined, MSVC doesn't define the former)
+ * - NEON on AArch64
+ * - Otherwise, plain scalar loops over the intbuiltins.h functions
+ *
+ * Define PLAINLIBS_INTVEC_FORCE_SCALAR (or PLAINLIBS_INTBUILTINS_FORCE_FALLBACK)
+ * to always use the scalar loops.
+ *
+ * Define PLAINLIBS_INTVEC_DISPATCH to also compile the AVX2 versions on x86
+ * (even without `-mavx2`), and use them if the CPU supports AVX2 at runtime.
+ * This requires "cpudispatch.h".
+ *
+ * There is no SIMD version of 64 bit multiplication, since neither AVX2 nor NEON
+ * has a 64x64 bit multiply. That is just a scalar loop.
+ *
+ * Dual-licensed under Creative Commons CC0 (Public Domain) and the MIT License.
+ *
+ * Source code & issue tracker: https://github.com/Techcable/plainlibs
+ *
+ * VERSION: 0.1.0-beta.3-dev
+ *
+ * CHANGELOG:
+ *
+ * NEXT:
+ * - Initial release
+ * - Added `PLAINLIBS_INTVEC_DISPATCH` to select AVX2 at runtime
+ */
+#ifndef PLAINLIBS_INTVEC_H
+#define PLAINLIBS_INTVEC_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "plain/intbuiltins.h"
+
+#if defined(PLAINLIBS_INTVEC_FORCE_SCALAR) || defined(PLAINLIBS_INTBUILTINS_FORCE_FALLBACK)
+// Only use scalar code
+#elif defined(__AVX2__)
+#define _PLAIN_INTVEC_AVX2
+#define _PLAIN_INTVEC_ISA avx2
+#define _PLAIN_INTVEC_LANES32 8
+#define _PLAIN_INTVEC_LANES64 4
+#include <immintrin.h>
+#elif defined(__SSE4_2__) || defined(__AVX__)
+#define _PLAIN_INTVEC_SSE42
+#define _PLAIN_INTVEC_ISA sse42
+#define _PLAIN_INTVEC_LANES32 4
+#define _PLAIN_INTVEC_LANES64 2
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define _PLAIN_INTVEC_NEON
+#define _PLAIN_INTVEC_ISA neon
+#define _PLAIN_INTVEC_LANES32 4
+#define _PLAIN_INTVEC_LANES64 2
+#include <arm_neon.h>
+#endif
+
+/*
+ * Runtime dispatch to AVX2 (opt-in, see cpudispatch.h)
+ *
+ * The AVX2 kernels are compiled with a target attribute, and used if the CPU supports AVX2.
+ * Otherwise, this falls back to whatever was selected at compile time.
+ */
+#if defined(PLAINLIBS_INTVEC_DISPATCH) && !defined(_PLAIN_INTVEC_AVX2) \
+    && !defined(PLAINLIBS_INTVEC_FORCE_SCALAR) && !defined(PLAINLIBS_INTBUILTINS_FORCE_FALLBACK) \
+    && (((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))) \
+        || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))))
+#define _PLAIN_INTVEC_AVX2_DISPATCH
+#include <immintrin.h>
+#include "plain/cpudispatch.h"
+#endif
+
+/*
+ * Scalar versions
+ *
+ * These are used for the leftover elements that don't fill a whole vector,
+ * and for everything if there is no SIMD support.
+ *
+ * They process the elements in [start, n) and return the first overflowing index (or n).
+ */
+
+#define _PLAIN_INTVEC_IMPL_SCALAR(tp, op, suffix) \
+    static inline size_t _plain_intvec_ ## op ## suffix ## _scalar( \
+        const tp *first, const tp *second, tp *out, size_t start, size_t n \
+    ) { \
+        size_t first_overflow = n; \
+        for (size_t i = start; i < n; i++) { \
+            bool overflow = plain_int_overflowing_ ## op ## suffix(first[i], second[i], &out[i]); \
+            if (overflow && first_overflow == n) { \
+                first_overflow = i; \
+            } \
+        } \
+        return first_overflow; \
+    }
+
+_PLAIN_INTVEC_IMPL_SCALAR(int32_t, add, 32s)
+_PLAIN_INTVEC_IMPL_SCALAR(int32_t, sub, 32s)
+_PLAIN_INTVEC_IMPL_SCALAR(int32_t, mul, 32s)
+_PLAIN_INTVEC_IMPL_SCALAR(int64_t, add, 64s)
+_PLAIN_INTVEC_IMPL_SCALAR(int64_t, sub, 64s)
+_PLAIN_INTVEC_IMPL_SCALAR(int64_t, mul, 64s)
+
+#undef _PLAIN_INTVEC_IMPL_SCALAR
+
+/**
+ * Adds `value` to a 64 bit signed sum, counting how many times it wraps around.
+ *
+ * Wrapping upwards (past INT64_MAX) increments `wraps`, and downwards decrements it.
+ * The true sum is `sum + wraps * 2^64`, so it fits exactly when `wraps` is zero.
+ */
+static inline void _plain_intvec_sum64s_step(int64_t *sum, int64_t *wraps, int64_t value) {
+    if (plain_int_overflowing_add64s(*sum, value, sum)) {
+        // Overflow can only happen in the direction of the value's sign
+        *wraps += value < 0 ? -1 : 1;
+    }
+}
+
+/**
+ * Adds `value` to a 64 bit unsigned sum, counting how many times it wraps around.
+ */
+static inline void _plain_intvec_sum64u_step(uint64_t *sum, uint64_t *wraps, uint64_t value) {
+    *wraps += plain_int_overflowing_add64u(*sum, value, sum);
+}
+
+/**
+ * Find the index of the lowest set bit in a nonzero mask of lanes.
+ */
+static inline size_t _plain_intvec_first_lane(unsigned mask) {
+    return (size_t)plain_int_ntz32(mask);
+}
+
+/*
+ * SIMD kernels
+ *
+ * Each elementwise kernel processes a single vector, storing the (wrapped) results
+ * and returning a bitmask of the overflowing lanes.
+ *
+ * Signed add/sub overflow uses the same test as the scalar fallbacks (see Hacker's Delight 2-13):
+ * The sign bit of `(res ^ first) & (res ^ second)` (or `(first ^ second) & (res ^ first)` for sub).
+ * On x86, movemask extracts the sign bits directly.
+ *
+ * Signed multiplication computes the full 64 bit products of the even & odd lanes.
+ * A product overflows if its high half is not the sign extension of the low half.
+ */
+
+/*
+ * Run an elementwise kernel over all the full vectors, then the scalar version on the rest.
+ */
+#define _PLAIN_INTVEC_ELEMENTWISE(lanes, kernel, scalar) do { \
+        size_t first_overflow = n; \
+        size_t i = 0; \
+        for (; i + (lanes) <= n; i += (lanes)) { \
+            unsigned mask = kernel(first + i, second + i, out + i); \
+            if (mask != 0 && first_overflow == n) { \
+                first_overflow = i + _plain_intvec_first_lane(mask); \
+            } \
+        } \
+        size_t tail_overflow = scalar(first, second, out, i, n); \
+        return first_overflow != n ? first_overflow : tail_overflow; \
+    } while (false)
+
+#if defined(_PLAIN_INTVEC_AVX2) || defined(_PLAIN_INTVEC_AVX2_DISPATCH)
+
+#if defined(_PLAIN_INTVEC_AVX2_DISPATCH) && defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(_PLAIN_INTVEC_AVX2_DISPATCH) && defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+static inline unsigned _plain_intvec_add32s_avx2(const int32_t *first, const int32_t *second, int32_t *out) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) first);
+    __m256i b = _mm256_loadu_si256((const __m256i*) second);
+    __m256i res = _mm256_add_epi32(a, b);
+    _mm256_storeu_si256((__m256i*) out, res);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(res, a), _mm256_xor_si256(res, b));
+    return (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(overflow));
+}
+
+static inline unsigned _plain_intvec_sub32s_avx2(const int32_t *first, const int32_t *second, int32_t *out) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) first);
+    __m256i b = _mm256_loadu_si256((const __m256i*) second);
+    __m256i res = _mm256_sub_epi32(a, b);
+    _mm256_storeu_si256((__m256i*) out, res);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(res, a));
+    return (unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(overflow));
+}
+
+/**
+ * Bitmask of the 64 bit products whose high half isn't the sign extension of the low half.
+ *
+ * The bits are in the odd positions (matching the high halves).
+ */
+static inline unsigned _plain_intvec_mul_overflow_mask_avx2(__m256i products) {
+    // Moves the sign of each low half into the position of the high half
+    __m256i expected_high = _mm256_slli_epi64(_mm256_srai_epi32(products, 31), 32);
+    __m256i matches = _mm256_cmpeq_epi32(products, expected_high);
+    return ~(unsigned) _mm256_movemask_ps(_mm256_castsi256_ps(matches)) & 0xAA;
+}
+
+static inline unsigned _plain_intvec_mul32s_avx2(const int32_t *first, const int32_t *second, int32_t *out) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) first);
+    __m256i b = _mm256_loadu_si256((const __m256i*) second);
+    _mm256_storeu_si256((__m256i*) out, _mm256_mullo_epi32(a, b));
+    __m256i even = _mm256_mul_epi32(a, b);
+    __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    return (_plain_intvec_mul_overflow_mask_avx2(even) >> 1) | _plain_intvec_mul_overflow_mask_avx2(odd);
+}
+
+static inline unsigned _plain_intvec_add64s_avx2(const int64_t *first, const int64_t *second, int64_t *out) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) first);
+    __m256i b = _mm256_loadu_si256((const __m256i*) second);
+    __m256i res = _mm256_add_epi64(a, b);
+    _mm256_storeu_si256((__m256i*) out, res);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(res, a), _mm256_xor_si256(res, b));
+    return (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(overflow));
+}
+
+static inline unsigned _plain_intvec_sub64s_avx2(const int64_t *first, const int64_t *second, int64_t *out) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) first);
+    __m256i b = _mm256_loadu_si256((const __m256i*) second);
+    __m256i res = _mm256_sub_epi64(a, b);
+    _mm256_storeu_si256((__m256i*) out, res);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(res, a));
+    return (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(overflow));
+}
+
+/**
+ * Add each lane of `values` to `sums`, counting signed wraparound in `wraps`.
+ *
+ * See _plain_intvec_sum64s_step
+ */
+static inline void _plain_intvec_sum64s_lanes_avx2(__m256i *sums, __m256i *wraps, __m256i values) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i res = _mm256_add_epi64(*sums, values);
+    __m256i overflow = _mm256_and_si256(_mm256_xor_si256(res, *sums), _mm256_xor_si256(res, values));
+    __m256i overflow_mask = _mm256_cmpgt_epi64(zero, overflow);
+    // -1 if the value is negative, otherwise +1
+    __m256i direction = _mm256_or_si256(_mm256_cmpgt_epi64(zero, values), _mm256_set1_epi64x(1));
+    *wraps = _mm256_add_epi64(*wraps, _mm256_and_si256(overflow_mask, direction));
+    *sums = res;
+}
+
+/**
+ * Combine the per-lane sums and wraparound counts into a single sum.
+ */
+static inline void _plain_intvec_sum64s_combine_avx2(__m256i sums, __m256i wraps, int64_t *sum, int64_t *total_wraps) {
+    int64_t lane_sums[4], lane_wraps[4];
+    _mm256_storeu_si256((__m256i*) lane_sums, sums);
+    _mm256_storeu_si256((__m256i*) lane_wraps, wraps);
+    for (int lane = 0; lane < 4; lane++) {
+        _plain_intvec_sum64s_step(sum, total_wraps, lane_sums[lane]);
+        *total_wraps += lane_wraps[lane];
+    }
+}
+
+static inline size_t _plain_intvec_sum64s_avx2(const int64_t *values, size_t n, int64_t *sum, int64_t *wraps) {
+    __m256i lane_sums = _mm256_setzero_si256(), lane_wraps = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _plain_intvec_sum64s_lanes_avx2(&lane_sums, &lane_wraps, _mm256_loadu_si256((const __m256i*) (values + i)));
+    }
+    _plain_intvec_sum64s_combine_avx2(lane_sums, lane_wraps, sum, wraps);
+    return i;
+}
+
+static inline size_t _plain_intvec_sum64u_avx2(const uint64_t *values, size_t n, uint64_t *sum, uint64_t *wraps) {
+    // AVX2 only has signed comparisons, so flip the sign bits to compare unsigned values
+    __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    __m256i lane_sums = _mm256_setzero_si256(), lane_wraps = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i res = _mm256_add_epi64(lane_sums, _mm256_loadu_si256((const __m256i*) (values + i)));
+        // Wrapped around if the result is less than the old sum. Subtracting the all-ones mask adds one.
+        __m256i carry = _mm256_cmpgt_epi64(_mm256_xor_si256(lane_sums, sign), _mm256_xor_si256(res, sign));
+        lane_wraps = _mm256_sub_epi64(lane_wraps, carry);
+        lane_sums = res;
+    }
+    uint64_t sums[4], carries[4];
+    _mm256_storeu_si256((__m256i*) sums, lane_sums);
+    _mm256_storeu_si256((__m256i*) carries, lane_wraps);
+    for (int lane = 0; lane < 4; lane++) {
+        _plain_intvec_sum64u_step(sum, wraps, sums[lane]);
+        *wraps += carries[lane];
+    }
+    return i;
+}
+
+static inline size_t _plain_intvec_sum32s_avx2(const int32_t *values, size_t n, int64_t *sum) {
+    __m256i lane_sums = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i narrow = _mm_loadu_si128((const __m128i*) (values + i));
+        lane_sums = _mm256_add_epi64(lane_sums, _mm256_cvtepi32_epi64(narrow));
+    }
+    int64_t sums[4];
+    _mm256_storeu_si256((__m256i*) sums, lane_sums);
+    *sum += sums[0] + sums[1] + sums[2] + sums[3];
+    return i;
+}
+
+static inline size_t _plain_intvec_dot32s_avx2(const int32_t *first, const int32_t *second, size_t n, int64_t *sum, int64_t *wraps) {
+    __m256i lane_sums = _mm256_setzero_si256(), lane_wraps = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i a = _mm256_loadu_si256((const __m256i*) (first + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (second + i));
+        // The products are at most 2^62 in magnitude, so only the sum can overflow
+        _plain_intvec_sum64s_lanes_avx2(&lane_sums, &lane_wraps, _mm256_mul_epi32(a, b));
+        __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+        _plain_intvec_sum64s_lanes_avx2(&lane_sums, &lane_wraps, odd);
+    }
+    _plain_intvec_sum64s_combine_avx2(lane_sums, lane_wraps, sum, wraps);
+    return i;
+}
+
+#if defined(_PLAIN_INTVEC_AVX2_DISPATCH)
+/*
+ * The public functions can't inline the AVX2 kernels (they have a different target),
+ * so the whole loop needs to be compiled for AVX2.
+ */
+#define _PLAIN_INTVEC_IMPL_AVX2_LOOP(tp, op, suffix, lanes) \
+    static inline size_t _plain_intvec_ ## op ## suffix ## _loop_avx2( \
+        const tp *first, const tp *second, tp *out, size_t n \
+    ) { \
+        _PLAIN_INTVEC_ELEMENTWISE(lanes, _plain_intvec_ ## op ## suffix ## _avx2, _plain_intvec_ ## op ## suffix ## _scalar); \
+    }
+
+_PLAIN_INTVEC_IMPL_AVX2_LOOP(int32_t, add, 32s, 8)
+_PLAIN_INTVEC_IMPL_AVX2_LOOP(int32_t, sub, 32s, 8)
+_PLAIN_INTVEC_IMPL_AVX2_LOOP(int32_t, mul, 32s, 8)
+_PLAIN_INTVEC_IMPL_AVX2_LOOP(int64_t, add, 64s, 4)
+_PLAIN_INTVEC_IMPL_AVX2_LOOP(int64_t, sub, 64s, 4)
+
+#undef _PLAIN_INTVEC_IMPL_AVX2_LOOP
+#endif
+
+#if defined(_PLAIN_INTVEC_AVX2_DISPATCH) && defined(__clang__)
+#pragma clang attribute pop
+#elif defined(_PLAIN_INTVEC_AVX2_DISPATCH) && defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
+
+#if defined(_PLAIN_INTVEC_SSE42)
+
+static inline unsigned _plain_intvec_add32s_sse42(const int32_t *first, const int32_t *second, int32_t *out) {
+    __m128i a = _mm_loadu_si128((const __m128i*) first);
+    __m128i b = _mm_loadu_si128((const __m128i*) second);
+    __m128i res = _mm_add_epi32(a, b);
+    _mm_storeu_si128((__m128i*) out, res);
+    __m128i overflow = _mm_and_si128(_mm_xor_si128(res, a), _mm_xor_si128(res, b));
+    return (unsigned) _mm_movemask_ps(_mm_castsi128_ps(overflow));
+}
+
+static inline unsigned _plain_intvec_sub32s_sse42(const int32_t *first, const int32_t *second, int32_t *out) {
+    __m128i a = _mm_loadu_si128((const __m128i*) first);
+    __m128i b = _mm_loadu_si128((const __m128i*) second);
+    __m128i res = _mm_sub_epi32(a, b);
+    _mm_storeu_si128((__m128i*) out, res);
+    __m128i overflow = _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(res, a));
+    return (unsigned) _mm_movemask_ps(_mm_castsi128_ps(overflow));
+}
+
+// See _plain_intvec_mul_overflow_mask_avx2
+static inline unsigned _plain_intvec_mul_overflow_mask_sse42(__m128i products) {
+    __m128i expected_high = _mm_slli_epi64(_mm_srai_epi32(products, 31), 32);
+    __m128i matches = _mm_cmpeq_epi32(products, expected_high);
+    return ~(unsigned) _mm_movemask_ps(_mm_castsi128_ps(matches)) & 0xA;
+}
+
+static inline unsigned _plain_intvec_mul32s_sse42(const int32_t *first, const int32_t *second, int32_t *out) {
+    __m128i a = _mm_loadu_si128((const __m128i*) first);
+    __m128i b = _mm_loadu_si128((const __m128i*) second);
+    _mm_storeu_si128((__m128i*) out, _mm_mullo_epi32(a, b));
+    __m128i even = _mm_mul_epi32(a, b);
+    __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return (_plain_intvec_mul_overflow_mask_sse42(even) >> 1) | _plain_intvec_mul_overflow_mask_sse42(odd);
+}
+
+static inline unsigned _plain_intvec_add64s_sse42(const int64_t *first, const int64_t *second, int64_t *out) {
+    __m128i a = _mm_loadu_si128((const __m128i*) first);
+    __m128i b = _mm_loadu_si128((const __m128i*) second);
+    __m128i res = _mm_add_epi64(a, b);
+    _mm_storeu_si128((__m128i*) out, res);
+    __m128i overflow = _mm_and_si128(_mm_xor_si128(res, a), _mm_xor_si128(res, b));
+    return (unsigned) _mm_movemask_pd(_mm_castsi128_pd(overflow));
+}
+
+static inline unsigned _plain_intvec_sub64s_sse42(const int64_t *first, const int64_t *second, int64_t *out) {
+    __m128i a = _mm_loadu_si128((const __m128i*) first);
+    __m128i b = _mm_loadu_si128((const __m128i*) second);
+    __m128i res = _mm_sub_epi64(a, b);
+    _mm_storeu_si128((__m128i*) out, res);
+    __m128i overflow = _mm_and_si128(_mm_xor_si128(a, b), _mm_xor_si128(res, a));
+    return (unsigned) _mm_movemask_pd(_mm_castsi128_pd(overflow));
+}
+
+// See _plain_intvec_sum64s_lanes_avx2
+static inline void _plain_intvec_sum64s_lanes_sse42(__m128i *sums, __m128i *wraps, __m128i values) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i res = _mm_add_epi64(*sums, values);
+    __m128i overflow = _mm_and_si128(_mm_xor_si128(res, *sums), _mm_xor_si128(res, values));
+    __m128i overflow_mask = _mm_cmpgt_epi64(zero, overflow);
+    __m128i direction = _mm_or_si128(_mm_cmpgt_epi64(zero, values), _mm_set1_epi64x(1));
+    *wraps = _mm_add_epi64(*wraps, _mm_and_si128(overflow_mask, direction));
+    *sums = res;
+}
+
+static inline void _plain_intvec_sum64s_combine_sse42(__m128i sums, __m128i wraps, int64_t *sum, int64_t *total_wraps) {
+    int64_t lane_sums[2], lane_wraps[2];
+    _mm_storeu_si128((__m128i*) lane_sums, sums);
+    _mm_storeu_si128((__m128i*) lane_wraps, wraps);
+    for (int lane = 0; lane < 2; lane++) {
+        _plain_intvec_sum64s_step(sum, total_wraps, lane_sums[lane]);
+        *total_wraps += lane_wraps[lane];
+    }
+}
+
+static inline size_t _plain_intvec_sum64s_sse42(const int64_t *values, size_t n, int64_t *sum, int64_t *wraps) {
+    __m128i lane_sums = _mm_setzero_si128(), lane_wraps = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _plain_intvec_sum64s_lanes_sse42(&lane_sums, &lane_wraps, _mm_loadu_si128((const __m128i*) (values + i)));
+    }
+    _plain_intvec_sum64s_combine_sse42(lane_sums, lane_wraps, sum, wraps);
+    return i;
+}
+
+static inline size_t _plain_intvec_sum64u_sse42(const uint64_t *values, size_t n, uint64_t *sum, uint64_t *wraps) {
+    // See _plain_intvec_sum64u_avx2
+    __m128i sign = _mm_set1_epi64x(INT64_MIN);
+    __m128i lane_sums = _mm_setzero_si128(), lane_wraps = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i res = _mm_add_epi64(lane_sums, _mm_loadu_si128((const __m128i*) (values + i)));
+        __m128i carry = _mm_cmpgt_epi64(_mm_xor_si128(lane_sums, sign), _mm_xor_si128(res, sign));
+        lane_wraps = _mm_sub_epi64(lane_wraps, carry);
+        lane_sums = res;
+    }
+    uint64_t sums[2], carries[2];
+    _mm_storeu_si128((__m128i*) sums, lane_sums);
+    _mm_storeu_si128((__m128i*) carries, lane_wraps);
+    for (int lane = 0; lane < 2; lane++) {
+        _plain_intvec_sum64u_step(sum, wraps, sums[lane]);
+        *wraps += carries[lane];
+    }
+    return i;
+}
+
+static inline size_t _plain_intvec_sum32s_sse42(const int32_t *values, size_t n, int64_t *sum) {
+    __m128i lane_sums = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i narrow = _mm_loadu_si128((const __m128i*) (values + i));
+        lane_sums = _mm_add_epi64(lane_sums, _mm_cvtepi32_epi64(narrow));
+        lane_sums = _mm_add_epi64(lane_sums, _mm_cvtepi32_epi64(_mm_srli_si128(narrow, 8)));
+    }
+    int64_t sums[2];
+    _mm_storeu_si128((__m128i*) sums, lane_sums);
+    *sum += sums[0] + sums[1];
+    return i;
+}
+
+static inline size_t _plain_intvec_dot32s_sse42(const int32_t *first, const int32_t *second, size_t n, int64_t *sum, int64_t *wraps) {
+    __m128i lane_sums = _mm_setzero_si128(), lane_wraps = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i a = _mm_loadu_si128((const __m128i*) (first + i));
+        __m128i b = _mm_loadu_si128((const __m128i*) (second + i));
+        _plain_intvec_sum64s_lanes_sse42(&lane_sums, &lane_wraps, _mm_mul_epi32(a, b));
+        __m128i odd = _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        _plain_intvec_sum64s_lanes_sse42(&lane_sums, &lane_wraps, odd);
+    }
+    _plain_intvec_sum64s_combine_sse42(lane_sums, lane_wraps, sum, wraps);
+    return i;
+}
+
+#elif defined(_PLAIN_INTVEC_NEON)
+
+/*
+ * NEON doesn't have movemask, so shift each overflowing lane's sign bit
+ * into its own bit position and add them together.
+ */
+static inline unsigned _plain_intvec_lane_mask32_neon(uint32x4_t overflow) {
+    static const int32_t SHIFTS[4] = {0, 1, 2, 3};
+    return vaddvq_u32(vshlq_u32(vshrq_n_u32(overflow, 31), vld1q_s32(SHIFTS)));
+}
+
+static inline unsigned _plain_intvec_lane_mask64_neon(uint64x2_t overflow) {
+    static const int64_t SHIFTS[2] = {0, 1};
+    return (unsigned) vaddvq_u64(vshlq_u64(vshrq_n_u64(overflow, 63), vld1q_s64(SHIFTS)));
+}
+
+static inline unsigned _plain_intvec_add32s_neon(const int32_t *first, const int32_t *second, int32_t *out) {
+    int32x4_t a = vld1q_s32(first), b = vld1q_s32(second);
+    int32x4_t res = vaddq_s32(a, b);
+    vst1q_s32(out, res);
+    int32x4_t overflow = vandq_s32(veorq_s32(res, a), veorq_s32(res, b));
+    return _plain_intvec_lane_mask32_neon(vreinterpretq_u32_s32(overflow));
+}
+
+static inline unsigned _plain_intvec_sub32s_neon(const int32_t *first, const int32_t *second, int32_t *out) {
+    int32x4_t a = vld1q_s32(first), b = vld1q_s32(second);
+    int32x4_t res = vsubq_s32(a, b);
+    vst1q_s32(out, res);
+    int32x4_t overflow = vandq_s32(veorq_s32(a, b), veorq_s32(res, a));
+    return _plain_intvec_lane_mask32_neon(vreinterpretq_u32_s32(overflow));
+}
+
+static inline unsigned _plain_intvec_mul32s_neon(const int32_t *first, const int32_t *second, int32_t *out) {
+    int32x4_t a = vld1q_s32(first), b = vld1q_s32(second);
+    int64x2_t low = vmull_s32(vget_low_s32(a), vget_low_s32(b));
+    int64x2_t high = vmull_high_s32(a, b);
+    int32x4_t res = vcombine_s32(vmovn_s64(low), vmovn_s64(high));
+    vst1q_s32(out, res);
+    // Narrowing with saturation only differs from truncation if the product doesn't fit
+    int32x4_t saturated = vcombine_s32(vqmovn_s64(low), vqmovn_s64(high));
+    return _plain_intvec_lane_mask32_neon(vmvnq_u32(vceqq_s32(res, saturated)));
+}
+
+static inline unsigned _plain_intvec_add64s_neon(const int64_t *first, const int64_t *second, int64_t *out) {
+    int64x2_t a = vld1q_s64(first), b = vld1q_s64(second);
+    int64x2_t res = vaddq_s64(a, b);
+    vst1q_s64(out, res);
+    int64x2_t overflow = vandq_s64(veorq_s64(res, a), veorq_s64(res, b));
+    return _plain_intvec_lane_mask64_neon(vreinterpretq_u64_s64(overflow));
+}
+
+static inline unsigned _plain_intvec_sub64s_neon(const int64_t *first, const int64_t *second, int64_t *out) {
+    int64x2_t a = vld1q_s64(first), b = vld1q_s64(second);
+    int64x2_t res = vsubq_s64(a, b);
+    vst1q_s64(out, res);
+    int64x2_t overflow = vandq_s64(veorq_s64(a, b), veorq_s64(res, a));
+    return _plain_intvec_lane_mask64_neon(vreinterpretq_u64_s64(overflow));
+}
+
+// See _plain_intvec_sum64s_lanes_avx2
+static inline void _plain_intvec_sum64s_lanes_neon(int64x2_t *sums, int64x2_t *wraps, int64x2_t values) {
+    int64x2_t res = vaddq_s64(*sums, values);
+    // Saturating addition only differs from wrapping addition on overflow
+    uint64x2_t same = vceqq_s64(res, vqaddq_s64(*sums, values));
+    uint64x2_t overflow_mask = vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(same)));
+    int64x2_t direction = vorrq_s64(vreinterpretq_s64_u64(vcltzq_s64(values)), vdupq_n_s64(1));
+    *wraps = vaddq_s64(*wraps, vandq_s64(vreinterpretq_s64_u64(overflow_mask), direction));
+    *sums = res;
+}
+
+static inline void _plain_intvec_sum64s_combine_neon(int64x2_t sums, int64x2_t wraps, int64_t *sum, int64_t *total_wraps) {
+    _plain_intvec_sum64s_step(sum, total_wraps, vgetq_lane_s64(sums, 0));
+    _plain_intvec_sum64s_step(sum, total_wraps, vgetq_lane_s64(sums, 1));
+    *total_wraps += vaddvq_s64(wraps);
+}
+
+static inline size_t _plain_intvec_sum64s_neon(const int64_t *values, size_t n, int64_t *sum, int64_t *wraps) {
+    int64x2_t lane_sums = vdupq_n_s64(0), lane_wraps = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _plain_intvec_sum64s_lanes_neon(&lane_sums, &lane_wraps, vld1q_s64(values + i));
+    }
+    _plain_intvec_sum64s_combine_neon(lane_sums, lane_wraps, sum, wraps);
+    return i;
+}
+
+static inline size_t _plain_intvec_sum64u_neon(const uint64_t *values, size_t n, uint64_t *sum, uint64_t *wraps) {
+    uint64x2_t lane_sums = vdupq_n_u64(0), lane_wraps = vdupq_n_u64(0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        uint64x2_t res = vaddq_u64(lane_sums, vld1q_u64(values + i));
+        // Wrapped around if the result is less than the old sum. Subtracting the all-ones mask adds one.
+        lane_wraps = vsubq_u64(lane_wraps, vcgtq_u64(lane_sums, res));
+        lane_sums = res;
+    }
+    _plain_intvec_sum64u_step(sum, wraps, vgetq_lane_u64(lane_sums, 0));
+    _plain_intvec_sum64u_step(sum, wraps, vgetq_lane_u64(lane_sums, 1));
+    *wraps += vaddvq_u64(lane_wraps);
+    return i;
+}
+
+static inline size_t _plain_intvec_sum32s_neon(const int32_t *values, size_t n, int64_t *sum) {
+    int64x2_t lane_sums = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // Pairwise add & accumulate into 64 bit lanes
+        lane_sums = vpadalq_s32(lane_sums, vld1q_s32(values + i));
+    }
+    *sum += vaddvq_s64(lane_sums);
+    return i;
+}
+
+static inline size_t _plain_intvec_dot32s_neon(const int32_t *first, const int32_t *second, size_t n, int64_t *sum, int64_t *wraps) {
+    int64x2_t lane_sums = vdupq_n_s64(0), lane_wraps = vdupq_n_s64(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t a = vld1q_s32(first + i), b = vld1q_s32(second + i);
+        _plain_intvec_sum64s_lanes_neon(&lane_sums, &lane_wraps, vmull_s32(vget_low_s32(a), vget_low_s32(b)));
+        _plain_intvec_sum64s_lanes_neon(&lane_sums, &lane_wraps, vmull_high_s32(a, b));
+    }
+    _plain_intvec_sum64s_combine_neon(lane_sums, lane_wraps, sum, wraps);
+    return i;
+}
+
+#endif
+
+#ifdef _PLAIN_INTVEC_ISA
+#define _PLAIN_INTVEC_KERNEL(name) _PLAIN_INTVEC_KERNEL_IMPL(name, _PLAIN_INTVEC_ISA)
+// Extra level of indirection to expand _PLAIN_INTVEC_ISA before pasting
+#define _PLAIN_INTVEC_KERNEL_IMPL(name, isa) _PLAIN_INTVEC_KERNEL_PASTE(name, isa)
+#define _PLAIN_INTVEC_KERNEL_PASTE(name, isa) _plain_intvec_ ## name ## _ ## isa
+#endif
+
+/*
+ * Run a sum kernel, returning the number of values it processed.
+ *
+ * This uses the AVX2 version if dispatching & the CPU supports it,
+ * otherwise the compile time selection (if any).
+ */
+#if defined(_PLAIN_INTVEC_AVX2_DISPATCH) && defined(_PLAIN_INTVEC_ISA)
+#define _PLAIN_INTVEC_RUN_KERNEL(name, ...) \
+    (PLAIN_CPU_HAS_AVX2() ? _plain_intvec_ ## name ## _avx2(__VA_ARGS__) : _PLAIN_INTVEC_KERNEL(name)(__VA_ARGS__))
+#elif defined(_PLAIN_INTVEC_AVX2_DISPATCH)
+#define _PLAIN_INTVEC_RUN_KERNEL(name, ...) \
+    (PLAIN_CPU_HAS_AVX2() ? _plain_intvec_ ## name ## _avx2(__VA_ARGS__) : (size_t) 0)
+#elif defined(_PLAIN_INTVEC_ISA)
+#define _PLAIN_INTVEC_RUN_KERNEL(name, ...) _PLAIN_INTVEC_KERNEL(name)(__VA_ARGS__)
+#else
+#define _PLAIN_INTVEC_RUN_KERNEL(name, ...) ((size_t) 0)
+#endif
+
+/*
+ * Elementwise operations
+ */
+
+#ifdef _PLAIN_INTVEC_AVX2_DISPATCH
+#define _PLAIN_INTVEC_DISPATCH_ELEMENTWISE(op, suffix) \
+    if (PLAIN_CPU_HAS_AVX2()) return _plain_intvec_ ## op ## suffix ## _loop_avx2(first, second, out, n)
+#else
+#define _PLAIN_INTVEC_DISPATCH_ELEMENTWISE(op, suffix) (void) 0
+#endif
+
+#ifdef _PLAIN_INTVEC_ISA
+#define _PLAIN_INTVEC_IMPL_ELEMENTWISE(tp, op, suffix, lanes) \
+    _PLAIN_INTVEC_DISPATCH_ELEMENTWISE(op, suffix); \
+    _PLAIN_INTVEC_ELEMENTWISE(lanes, _PLAIN_INTVEC_KERNEL(op ## suffix), _plain_intvec_ ## op ## suffix ## _scalar)
+#else
+#define _PLAIN_INTVEC_IMPL_ELEMENTWISE(tp, op, suffix, lanes) \
+    _PLAIN_INTVEC_DISPATCH_ELEMENTWISE(op, suffix); \
+    return _plain_intvec_ ## op ## suffix ## _scalar(first, second, out, 0, n)
+#endif
+
+/**
+ * Adds each pair of elements, checking for overflow.
+ *
+ * Returns the index of the first overflowing element, or `n` if none overflowed.
+ * All the results are computed using twos complement wrapping.
+ *
+ * See plain_int_overflowing_add32s
+ */
+static inline size_t plain_intvec_add32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    _PLAIN_INTVEC_IMPL_ELEMENTWISE(int32_t, add, 32s, _PLAIN_INTVEC_LANES32);
+}
+
+/**
+ * Subtracts each pair of elements, checking for overflow.
+ *
+ * Returns the index of the first overflowing element, or `n` if none overflowed.
+ *
+ * See plain_int_overflowing_sub32s
+ */
+static inline size_t plain_intvec_sub32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    _PLAIN_INTVEC_IMPL_ELEMENTWISE(int32_t, sub, 32s, _PLAIN_INTVEC_LANES32);
+}
+
+/**
+ * Multiplies each pair of elements, checking for overflow.
+ *
+ * Returns the index of the first overflowing element, or `n` if none overflowed.
+ *
+ * See plain_int_overflowing_mul32s
+ */
+static inline size_t plain_intvec_mul32s(const int32_t *first, const int32_t *second, int32_t *out, size_t n) {
+    _PLAIN_INTVEC_IMPL_ELEMENTWISE(int32_t, mul, 32s, _PLAIN_INTVEC_LANES32);
+}
+
+/**
+ * Adds each pair of elements, checking for overflow.
+ *
+ * Returns the index of the first overflowing element, or `n` if none overflowed.
+ *
+ * See plain_int_overflowing_add64s
+ */
+static inline size_t plain_intvec_add64s(const int64_t *first, const int64_t *second, int64_t *out, size_t n) {
+    _PLAIN_INTVEC_IMPL_ELEMENTWISE(int64_t, add, 64s, _PLAIN_INTVEC_LANES64);
+}
+
+/**
+ * Subtracts each pair of elements, checking for overflow.
+ *
+ * Returns the index of the first overflowing element, or `n` if none overflowed.
+ *
+ * See plain_int_overflowing_sub64s
+ */
+static inline size_t plain_intvec_sub64s(const int64_t *first, const int64_t *second, int64_t *out, size_t n) {
+    _PLAIN_INTVEC_IMPL_ELEMENTWISE(int64_t, sub, 64s, _PLAIN_INTVEC_LANES64);
+}
+
+/**
+ * Multiplies each pair of elements, checking for overflow.
+ *
+ * Returns the index of the first overflowing element, or `n` if none overflowed.
+ *
+ * This is always a scalar loop (there's no SIMD 64 bit multiply).
+ *
+ * See plain_int_overflowing_mul64s
+ */
+static inline size_t plain_intvec_mul64s(const int64_t *first, const int64_t *second, int64_t *out, size_t n) {
+    return _plain_intvec_mul64s_scalar(first, second, out, 0, n);
+}
+
+#undef _PLAIN_INTVEC_IMPL_ELEMENTWISE
+#undef _PLAIN_INTVEC_DISPATCH_ELEMENTWISE
+
+/*
+ * Sums & dot products
+ */
+
+/**
+ * Sums the specified values, checking for overflow.
+ *
+ * Returns true if the sum doesn't fit in an int64_t.
+ * The result is computed using twos complement wrapping.
+ *
+ * Intermediate overflow doesn't matter (only the final result),
+ * so this gives the same answer regardless of the order of the values.
+ */
+static inline bool plain_intvec_sum64s(const int64_t *values, size_t n, int64_t *res) {
+    int64_t sum = 0, wraps = 0;
+    size_t i = _PLAIN_INTVEC_RUN_KERNEL(sum64s, values, n, &sum, &wraps);
+    for (; i < n; i++) {
+        _plain_intvec_sum64s_step(&sum, &wraps, values[i]);
+    }
+    *res = sum;
+    return wraps != 0;
+}
+
+/**
+ * Sums the specified values, checking for overflow.
+ *
+ * Returns true if the sum doesn't fit in an uint64_t.
+ * The result is computed using wrapping arithmetic.
+ */
+static inline bool plain_intvec_sum64u(const uint64_t *values, size_t n, uint64_t *res) {
+    uint64_t sum = 0, wraps = 0;
+    size_t i = _PLAIN_INTVEC_RUN_KERNEL(sum64u, values, n, &sum, &wraps);
+    for (; i < n; i++) {
+        _plain_intvec_sum64u_step(&sum, &wraps, values[i]);
+    }
+    *res = sum;
+    return wraps != 0;
+}
+
+/**
+ * Sums the specified values into a 64 bit integer.
+ *
+ * This can't overflow unless there are more than 2^32 values.
+ */
+static inline int64_t plain_intvec_sum32s(const int32_t *values, size_t n) {
+    int64_t sum = 0;
+    size_t i = _PLAIN_INTVEC_RUN_KERNEL(sum32s, values, n, &sum);
+    for (; i < n; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+/**
+ * Computes the dot product of two arrays, checking for overflow.
+ *
+ * The products are computed as 64 bit integers (so they can't overflow).
+ *
+ * Returns true if the sum doesn't fit in an int64_t.
+ * The result is computed using twos complement wrapping.
+ */
+static inline bool plain_intvec_dot32s(const int32_t *first, const int32_t *second, size_t n, int64_t *res) {
+    int64_t sum = 0, wraps = 0;
+    size_t i = _PLAIN_INTVEC_RUN_KERNEL(dot32s, first, second, n, &sum, &wraps);
+    for (; i < n; i++) {
+        _plain_intvec_sum64s_step(&sum, &wraps, ((int64_t) first[i]) * second[i]);
+    }
+    *res = sum;
+    return wraps != 0;
+}
+
+#endif /* PLAINLIBS_INTVEC_H */
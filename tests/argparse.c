@@ -3,6 +3,10 @@
 #include <criterion/criterion.h>
 #include <criterion/new/assert.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunused-value"
@@ -43,6 +47,43 @@ static void parse_simple_flags(struct arg_parser* parser, struct simple_flags* f
         }
     }
 }
+enum simple_flag_idx { FOO_IDX, BAR_IDX, BAZ_IDX, LONG_ONLY_VALUE_IDX, NUM_SIMPLE_FLAGS };
+static const char* TABLE_FOO_ALIASES[] = {"foozie", NULL};
+static const char* TABLE_BAZ_ALIASES[] = {"bazzie", NULL};
+static const struct arg_config SIMPLE_FLAGS_TABLE[NUM_SIMPLE_FLAGS] = {
+    [FOO_IDX] = {.full_name = "foo", .short_name = "f", .aliases = TABLE_FOO_ALIASES},
+    [BAR_IDX] = {.full_name = "bar", .flag = true, .short_name = "b"},
+    [BAZ_IDX] = {.full_name = "baz", .flag = true, .aliases = TABLE_BAZ_ALIASES},
+    [LONG_ONLY_VALUE_IDX] = {.full_name = "long-only-value"},
+};
+
+static void parse_simple_flags_table(struct arg_parser* parser, struct simple_flags* flags) {
+    struct arg_table table = init_arg_table(SIMPLE_FLAGS_TABLE, NUM_SIMPLE_FLAGS);
+    int idx;
+    while ((idx = match_arg_table(parser, &table)) != ARG_TABLE_FINISHED) {
+        switch (idx) {
+            case FOO_IDX:
+                cr_assert(ne(ptr, parser->current_value, NULL));
+                flags->foo = parser->current_value;
+                break;
+            case BAR_IDX:
+                cr_assert(eq(ptr, parser->current_value, NULL));
+                flags->bar = true;
+                break;
+            case BAZ_IDX:
+                cr_assert(eq(ptr, parser->current_value, NULL));
+                flags->baz = true;
+                break;
+            case LONG_ONLY_VALUE_IDX:
+                cr_assert(ne(ptr, parser->current_value, NULL));
+                flags->long_only_value = parser->current_value;
+                break;
+            default:
+                cr_fail("Unknown flag: %s", current_arg(parser));
+        }
+    }
+    free_arg_table(&table);
+}
 static bool nullsafe_eq(const char* first, const char* second) {
     if (first == NULL)
         return second == NULL;
@@ -71,6 +112,13 @@ static size_t parse_positional(struct arg_parser* parser, char* buf[POS_BUF_SIZE
     return len;
 }
 
+static void write_file(const char* path, const char* contents) {
+    FILE* f = fopen(path, "wb");
+    cr_assert(ne(ptr, f, NULL), "Unable to create %s", path);
+    fputs(contents, f);
+    fclose(f);
+}
+
 Test(argparse, empty_args) {
     static char* ARGS[] = {"exe", NULL};
     struct arg_parser parser = init_args(1, ARGS);
@@ -90,6 +138,49 @@ Test(argparse, only_positional) {
     }
 }
 
+Test(argparse, remaining_args) {
+    static char* ARGS[] = {"exe", "-b", "first", "second", "third", NULL};
+    struct arg_parser parser = init_args(5, ARGS);
+    struct simple_flags flags = {0};
+    parse_simple_flags(&parser, &flags);
+    char** remaining = NULL;
+    int count = 0;
+    cr_assert(consume_remaining_args(&parser, &remaining, &count));
+    cr_assert(eq(int, count, 3));
+    cr_assert(eq(ptr, remaining, &ARGS[2]), "Should be a slice of argv");
+    cr_assert(not(has_args(&parser)));
+    cr_assert(consume_remaining_args(&parser, &remaining, &count));
+    cr_assert(eq(int, count, 0));
+}
+
+Test(argparse, args_chunks) {
+    write_file("argparse-test-chunks.rsp", "second third");
+    static char* ARGS[] = {"exe", "first", "@argparse-test-chunks.rsp", "fourth", NULL};
+    for (int expand = 0; expand <= 1; expand++) {
+        struct arg_parser parser = init_args(4, ARGS);
+        parser.expand_response_files = expand;
+        cr_assert(not(has_flag_args(&parser)));
+        char* buf[2];
+        cr_assert(eq(uptr, consume_args_chunk(&parser, buf, 2), 2));
+        cr_assert(eq(str, buf[0], "first"));
+        cr_assert(eq(str, buf[1], expand ? "second" : "@argparse-test-chunks.rsp"));
+        if (expand) {
+            char** remaining = NULL;
+            int count = 0;
+            cr_assert(not(consume_remaining_args(&parser, &remaining, &count)));
+            cr_assert(eq(uptr, consume_args_chunk(&parser, buf, 2), 2));
+            cr_assert(eq(str, buf[0], "third"));
+            cr_assert(eq(str, buf[1], "fourth"));
+        } else {
+            cr_assert(eq(uptr, consume_args_chunk(&parser, buf, 2), 1));
+            cr_assert(eq(str, buf[0], "fourth"));
+        }
+        cr_assert(eq(uptr, consume_args_chunk(&parser, buf, 2), 0));
+        free_args(&parser);
+    }
+    remove("argparse-test-chunks.rsp");
+}
+
 Test(argparse, basic_flags) {
     static char* ARGS[] = {"exe", "--foo", "foot", "--baz", "-b" /* bar */, NULL};
     struct simple_flags expected_flags = {
@@ -104,6 +195,332 @@ Test(argparse, basic_flags) {
     assert_flags_equal(&expected_flags, &actual_flags);
 }
 
+Test(argparse, table_flags) {
+    static char* ARGS[] = {"exe", "--bazzie", "-f", "foot", "--long-only-value", "val", "-b", "pos", NULL};
+    struct simple_flags expected_flags = {
+        .foo = "foot",
+        .bar = true,
+        .baz = true,
+        .long_only_value = "val",
+    };
+    struct arg_parser parser = init_args(8, ARGS);
+    struct simple_flags actual_flags = {0};
+    parse_simple_flags_table(&parser, &actual_flags);
+    assert_flags_equal(&expected_flags, &actual_flags);
+    char* buf[POS_BUF_SIZE];
+    cr_assert(eq(uptr, parse_positional(&parser, buf), 1));
+    cr_assert(eq(str, buf[0], "pos"));
+}
+
+Test(argparse, table_unknown_flag) {
+    static char* ARGS[] = {"exe", "--foozie", "bar", "--unknown", NULL};
+    struct arg_parser parser = init_args(4, ARGS);
+    struct arg_table table = init_arg_table(SIMPLE_FLAGS_TABLE, NUM_SIMPLE_FLAGS);
+    cr_assert(eq(int, match_arg_table(&parser, &table), FOO_IDX));
+    cr_assert(eq(str, parser.current_value, "bar"));
+    cr_assert(eq(int, match_arg_table(&parser, &table), ARG_TABLE_UNKNOWN));
+    cr_assert(eq(str, current_arg(&parser), "--unknown"));
+    free_arg_table(&table);
+}
+
+Test(argparse, inline_values) {
+    static char* ARGS[] = {"exe", "--foozie=a=b", "--long-only-value=", "--bazzie", "pos", NULL};
+    struct simple_flags expected_flags = {
+        .foo = "a=b",
+        .baz = true,
+        .long_only_value = "",
+    };
+    struct arg_parser parser = init_args(5, ARGS);
+    struct simple_flags actual_flags = {0};
+    parse_simple_flags(&parser, &actual_flags);
+    assert_flags_equal(&expected_flags, &actual_flags);
+    // The values point directly into argv
+    cr_assert(eq(ptr, actual_flags.foo, &ARGS[1][9]));
+    cr_assert(eq(str, current_arg(&parser), "pos"));
+}
+
+Test(argparse, bundled_short_flags) {
+    static char* ARGS[] = {"exe", "-bf", "foot", "-bffoo", "--", "-b", NULL};
+    struct arg_parser parser = init_args(6, ARGS);
+    struct simple_flags actual_flags = {0};
+    parse_simple_flags(&parser, &actual_flags);
+    // The value of the second -f comes from the rest of the bundle
+    struct simple_flags expected_flags = {.foo = "foo", .bar = true};
+    assert_flags_equal(&expected_flags, &actual_flags);
+    cr_assert(eq(uptr, parser.current_value_len, 3));
+    cr_assert(eq(str, current_arg(&parser), "-b"));
+}
+
+Test(argparse, table_inline_values) {
+    static char* ARGS[] = {"exe", "-bffoot", "--long-only-value=val", NULL};
+    struct simple_flags expected_flags = {
+        .foo = "foot",
+        .bar = true,
+        .long_only_value = "val",
+    };
+    struct arg_parser parser = init_args(3, ARGS);
+    struct simple_flags actual_flags = {0};
+    parse_simple_flags_table(&parser, &actual_flags);
+    assert_flags_equal(&expected_flags, &actual_flags);
+    cr_assert(not(has_args(&parser)));
+}
+
+static enum arg_value_status parse_int64_str(const char* value, unsigned flags, int64_t* res) {
+    return parse_int64_value(value, strlen(value), flags, res);
+}
+static enum arg_value_status parse_uint64_str(const char* value, unsigned flags, uint64_t* res) {
+    return parse_uint64_value(value, strlen(value), flags, res);
+}
+
+Test(argparse, int_values) {
+    int64_t res = 0;
+    cr_assert(eq(int, parse_int64_str("-17", 0, &res), ARG_VALUE_OK));
+    cr_assert(eq(i64, res, -17));
+    cr_assert(eq(int, parse_int64_str("+42", 0, &res), ARG_VALUE_OK));
+    cr_assert(eq(i64, res, 42));
+    cr_assert(eq(int, parse_int64_str("9223372036854775807", 0, &res), ARG_VALUE_OK));
+    cr_assert(eq(i64, res, INT64_MAX));
+    cr_assert(eq(int, parse_int64_str("-9223372036854775808", 0, &res), ARG_VALUE_OK));
+    cr_assert(eq(i64, res, INT64_MIN));
+    cr_assert(eq(int, parse_int64_str("9223372036854775808", 0, &res), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(int, parse_int64_str("-9223372036854775809", 0, &res), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(int, parse_int64_str("100000000000000000000000", 0, &res), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(i64, res, INT64_MIN), "Errors shouldn't modify the result");
+    cr_assert(eq(int, parse_int64_str("", 0, &res), ARG_VALUE_INVALID));
+    cr_assert(eq(int, parse_int64_str("-", 0, &res), ARG_VALUE_INVALID));
+    cr_assert(eq(int, parse_int64_str(" 7", 0, &res), ARG_VALUE_INVALID));
+    cr_assert(eq(int, parse_int64_str("7x", 0, &res), ARG_VALUE_INVALID));
+    cr_assert(eq(int, parse_int64_str("16k", 0, &res), ARG_VALUE_INVALID));
+    cr_assert(eq(int, parse_int64_str("16k", ARG_INT_SIZE_SUFFIX, &res), ARG_VALUE_OK));
+    cr_assert(eq(i64, res, 16384));
+    cr_assert(eq(int, parse_int64_str("-3G", ARG_INT_SIZE_SUFFIX, &res), ARG_VALUE_OK));
+    cr_assert(eq(i64, res, -3LL * (1 << 30)));
+    cr_assert(eq(int, parse_int64_str("8388608T", ARG_INT_SIZE_SUFFIX, &res), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(int, parse_int64_str("k", ARG_INT_SIZE_SUFFIX, &res), ARG_VALUE_INVALID));
+    int32_t res32 = 0;
+    cr_assert(eq(int, parse_int32_value("2147483648", 10, 0, &res32), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(int, parse_int32_value("-2147483648", 11, 0, &res32), ARG_VALUE_OK));
+    cr_assert(eq(i32, res32, INT32_MIN));
+}
+
+Test(argparse, uint_values) {
+    uint64_t res = 0;
+    cr_assert(eq(int, parse_uint64_str("18446744073709551615", 0, &res), ARG_VALUE_OK));
+    cr_assert(eq(u64, res, UINT64_MAX));
+    cr_assert(eq(int, parse_uint64_str("18446744073709551616", 0, &res), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(int, parse_uint64_str("28446744073709551615", 0, &res), ARG_VALUE_OVERFLOW));
+    cr_assert(eq(int, parse_uint64_str("-1", 0, &res), ARG_VALUE_INVALID));
+    cr_assert(eq(int, parse_uint64_str("+1M", ARG_INT_SIZE_SUFFIX, &res), ARG_VALUE_OK));
+    cr_assert(eq(u64, res, 1 << 20));
+    cr_assert(eq(int, parse_uint64_str("16777216T", ARG_INT_SIZE_SUFFIX, &res), ARG_VALUE_OVERFLOW));
+}
+
+Test(argparse, current_value_int) {
+    static char* ARGS[] = {"exe", "--foo=12k", "--long-only-value", "-5", NULL};
+    struct arg_parser parser = init_args(4, ARGS);
+    uint64_t foo = 0;
+    int32_t long_only_value = 0;
+    cr_assert(match_arg(&parser, "foo", &(struct arg_config){0}));
+    cr_assert(eq(int, current_value_uint64(&parser, ARG_INT_SIZE_SUFFIX, &foo), ARG_VALUE_OK));
+    cr_assert(eq(u64, foo, 12 * 1024));
+    cr_assert(match_arg(&parser, "long-only-value", NULL));
+    cr_assert(eq(int, current_value_int32(&parser, 0, &long_only_value), ARG_VALUE_OK));
+    cr_assert(eq(i32, long_only_value, -5));
+}
+
+Test(argparse, response_files) {
+    write_file("argparse-test-outer.rsp", "--foo 'a b'\n  @argparse-test-inner.rsp\tpos\\ 1 \"pos 2\"");
+    // NOTE: The final token has no trailing whitespace
+    write_file("argparse-test-inner.rsp", "--long-only-value=\"x\"y -b");
+    static char* ARGS[] = {"exe", "@argparse-test-outer.rsp", "--baz", "@argparse-test-inner.rsp", NULL};
+    struct arg_parser parser = init_args(4, ARGS);
+    parser.expand_response_files = true;
+    struct simple_flags actual_flags = {0};
+    parse_simple_flags(&parser, &actual_flags);
+    struct simple_flags expected_flags = {.foo = "a b", .bar = true, .long_only_value = "xy"};
+    assert_flags_equal(&expected_flags, &actual_flags);
+    char* buf[POS_BUF_SIZE];
+    size_t len = parse_positional(&parser, buf);
+    cr_assert(eq(uptr, len, 5));
+    cr_assert(eq(str, buf[0], "pos 1"));
+    cr_assert(eq(str, buf[1], "pos 2"));
+    cr_assert(eq(str, buf[2], "--baz"));
+    cr_assert(eq(str, buf[3], "--long-only-value=xy"));
+    cr_assert(eq(str, buf[4], "-b"));
+    free_args(&parser);
+    remove("argparse-test-outer.rsp");
+    remove("argparse-test-inner.rsp");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+Test(argparse, response_files_pipe) {
+    // Pipes report a size of zero, so they can't be memory-mapped
+    int fds[2];
+    cr_assert(eq(int, pipe(fds), 0));
+    static const char CONTENTS[] = "-b 'pos 1'";
+    cr_assert(eq(int, (int)write(fds[1], CONTENTS, sizeof(CONTENTS) - 1), (int)sizeof(CONTENTS) - 1));
+    close(fds[1]);
+    char path[64];
+    snprintf(path, sizeof(path), "@/dev/fd/%d", fds[0]);
+    char* args[] = {"exe", path, "pos 2", NULL};
+    struct arg_parser parser = init_args(3, args);
+    parser.expand_response_files = true;
+    struct simple_flags flags = {0};
+    parse_simple_flags(&parser, &flags);
+    cr_assert(flags.bar);
+    char* buf[POS_BUF_SIZE];
+    cr_assert(eq(uptr, parse_positional(&parser, buf), 2));
+    cr_assert(eq(str, buf[0], "pos 1"));
+    cr_assert(eq(str, buf[1], "pos 2"));
+    free_args(&parser);
+    close(fds[0]);
+}
+#endif
+
+Test(argparse, response_files_disabled) {
+    static char* ARGS[] = {"exe", "@missing.rsp", NULL};
+    struct arg_parser parser = init_args(2, ARGS);
+    cr_assert(not(has_flag_args(&parser)));
+    cr_assert(eq(str, consume_arg(&parser), "@missing.rsp"));
+}
+
+Test(argparse, return_errors) {
+    static char* ARGS[] = {"exe", "-b", "--foo", NULL};
+    struct arg_parser parser = init_args(3, ARGS);
+    parser.return_errors = true;
+    struct arg_table table = init_arg_table(SIMPLE_FLAGS_TABLE, NUM_SIMPLE_FLAGS);
+    cr_assert(eq(int, match_arg_table(&parser, &table), BAR_IDX));
+    cr_assert(eq(int, match_arg_table(&parser, &table), ARG_TABLE_ERROR));
+    cr_assert(eq(int, parser.error.kind, ARG_ERROR_MISSING_VALUE));
+    cr_assert(eq(int, parser.error.idx, 2));
+    cr_assert(eq(str, parser.error.name, "foo"));
+    // The parser stops after the first error
+    cr_assert(not(has_args(&parser)));
+    cr_assert(eq(int, match_arg_table(&parser, &table), ARG_TABLE_ERROR));
+    free_arg_table(&table);
+
+    static char* FLAG_VALUE_ARGS[] = {"exe", "--baz=1", NULL};
+    parser = init_args(2, FLAG_VALUE_ARGS);
+    parser.return_errors = true;
+    cr_assert(not(match_arg(&parser, "baz", &SIMPLE_FLAGS_TABLE[BAZ_IDX])));
+    cr_assert(eq(int, parser.error.kind, ARG_ERROR_UNEXPECTED_VALUE));
+    cr_assert(eq(str, parser.error.name, "baz"));
+}
+
+Test(argparse, return_errors_response_files) {
+    static char* ARGS[] = {"exe", "-b", "@argparse-test-missing.rsp", NULL};
+    struct arg_parser parser = init_args(3, ARGS);
+    parser.return_errors = true;
+    parser.expand_response_files = true;
+    cr_assert(match_arg(&parser, "bar", &(struct arg_config){.short_name = "b", .flag = true}));
+    cr_assert(not(has_args(&parser)));
+    cr_assert(eq(int, parser.error.kind, ARG_ERROR_RESPONSE_FILE));
+    cr_assert(eq(int, parser.error.idx, 2));
+    cr_assert(eq(str, parser.error.name, "argparse-test-missing.rsp"));
+
+    // A response file that includes itself
+    write_file("argparse-test-recursive.rsp", "-b @argparse-test-recursive.rsp");
+    static char* RECURSIVE_ARGS[] = {"exe", "@argparse-test-recursive.rsp", NULL};
+    parser = init_args(2, RECURSIVE_ARGS);
+    parser.return_errors = true;
+    parser.expand_response_files = true;
+    struct simple_flags flags = {0};
+    parse_simple_flags(&parser, &flags);
+    cr_assert(eq(int, parser.error.kind, ARG_ERROR_RESPONSE_FILE_DEPTH));
+    cr_assert(eq(int, parser.error.idx, 1));
+    free_args(&parser);
+    remove("argparse-test-recursive.rsp");
+
+    write_file("argparse-test-unterminated.rsp", "a b \"c d");
+    static char* UNTERMINATED_ARGS[] = {"exe", "@argparse-test-unterminated.rsp", NULL};
+    parser = init_args(2, UNTERMINATED_ARGS);
+    parser.return_errors = true;
+    parser.expand_response_files = true;
+    char* buf[POS_BUF_SIZE];
+    cr_assert(eq(uptr, parse_positional(&parser, buf), 2));
+    cr_assert(eq(int, parser.error.kind, ARG_ERROR_RESPONSE_FILE_SYNTAX));
+    cr_assert(eq(int, parser.error.idx, 1));
+    free_args(&parser);
+    remove("argparse-test-unterminated.rsp");
+}
+
+static const struct arg_subcommand SUBCOMMANDS[] = {
+    {"add"},
+    {"checkout"},
+    {"cherry-pick"},
+    {"commit"},
+};
+enum { NUM_SUBCOMMANDS = sizeof(SUBCOMMANDS) / sizeof(SUBCOMMANDS[0]) };
+
+static int parse_subcommand(char** args, int num_args, bool allow_prefix, struct simple_flags* flags) {
+    struct arg_parser parser = init_args(num_args, args);
+    parse_simple_flags(&parser, flags);
+    struct arg_parser child;
+    int idx = match_subcommand(&parser, SUBCOMMANDS, NUM_SUBCOMMANDS, allow_prefix, &child);
+    if (idx >= 0) {
+        cr_assert(not(has_args(&parser)), "Child should take the remaining args");
+        parse_simple_flags(&child, flags);
+        cr_assert(not(has_args(&child)));
+    }
+    return idx;
+}
+
+Test(argparse, subcommands) {
+    static char* ARGS[] = {"exe", "-b", "commit", "--baz", NULL};
+    struct simple_flags flags = {0};
+    cr_assert(eq(int, parse_subcommand(ARGS, 4, false, &flags), 3));
+    cr_assert(flags.bar);
+    cr_assert(flags.baz);
+    static char* PREFIX_ARGS[] = {"exe", "a", NULL};
+    cr_assert(eq(int, parse_subcommand(PREFIX_ARGS, 2, true, &flags), 0));
+    cr_assert(eq(int, parse_subcommand(PREFIX_ARGS, 2, false, &flags), ARG_SUBCOMMAND_UNKNOWN));
+    static char* CHERRY_ARGS[] = {"exe", "cher", NULL};
+    cr_assert(eq(int, parse_subcommand(CHERRY_ARGS, 2, true, &flags), 2));
+    static char* AMBIGUOUS_ARGS[] = {"exe", "ch", NULL};
+    cr_assert(eq(int, parse_subcommand(AMBIGUOUS_ARGS, 2, true, &flags), ARG_SUBCOMMAND_AMBIGUOUS));
+    static char* UNKNOWN_ARGS[] = {"exe", "zebra", NULL};
+    cr_assert(eq(int, parse_subcommand(UNKNOWN_ARGS, 2, true, &flags), ARG_SUBCOMMAND_UNKNOWN));
+    static char* MISSING_ARGS[] = {"exe", "-b", NULL};
+    cr_assert(eq(int, parse_subcommand(MISSING_ARGS, 2, true, &flags), ARG_SUBCOMMAND_MISSING));
+    // The empty string isn't a prefix of anything (even with a single subcommand)
+    static char* EMPTY_ARGS[] = {"exe", "", NULL};
+    cr_assert(eq(int, parse_subcommand(EMPTY_ARGS, 2, true, &flags), ARG_SUBCOMMAND_UNKNOWN));
+    static const struct arg_subcommand BUILD[] = {{"build"}};
+    struct arg_parser parser = init_args(2, EMPTY_ARGS);
+    struct arg_parser child;
+    cr_assert(eq(int, match_subcommand(&parser, BUILD, 1, true, &child), ARG_SUBCOMMAND_UNKNOWN));
+    // Flags have to be parsed before the subcommand
+    static char* FLAG_ARGS[] = {"exe", "--foo", "commit", NULL};
+    parser = init_args(3, FLAG_ARGS);
+    cr_assert(eq(int, match_subcommand(&parser, SUBCOMMANDS, NUM_SUBCOMMANDS, true, &child), ARG_SUBCOMMAND_UNPARSED_FLAGS));
+    cr_assert(eq(str, current_arg(&parser), "--foo"));
+}
+
+Test(argparse, table_many_flags) {
+    // Enough names (and aliases) to give the perfect hash some real work
+    enum { NUM_CONFIGS = 500 };
+    static char NAMES[NUM_CONFIGS][2][24];
+    static const char* ALIASES[NUM_CONFIGS][2];
+    static struct arg_config CONFIGS[NUM_CONFIGS];
+    for (int i = 0; i < NUM_CONFIGS; i++) {
+        snprintf(NAMES[i][0], sizeof(NAMES[i][0]), "option-%d", i);
+        snprintf(NAMES[i][1], sizeof(NAMES[i][1]), "alias-%d", i);
+        ALIASES[i][0] = NAMES[i][1];
+        ALIASES[i][1] = NULL;
+        CONFIGS[i] = (struct arg_config){.full_name = NAMES[i][0], .aliases = ALIASES[i], .flag = true};
+    }
+    struct arg_table table = init_arg_table(CONFIGS, NUM_CONFIGS);
+    for (int i = 0; i < NUM_CONFIGS; i++) {
+        char flag[32];
+        snprintf(flag, sizeof(flag), "--%s", NAMES[i][i % 2]);
+        char* args[] = {"exe", flag, "--option-missing", NULL};
+        struct arg_parser parser = init_args(3, args);
+        cr_assert(eq(int, match_arg_table(&parser, &table), i), "Expected %s to match", flag);
+        cr_assert(eq(int, match_arg_table(&parser, &table), ARG_TABLE_UNKNOWN));
+    }
+    free_arg_table(&table);
+}
+
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
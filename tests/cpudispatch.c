@@ -0,0 +1,40 @@
+#include "plain/cpudispatch.h"
+
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+Test(cpudispatch, features) {
+    unsigned features = plain_cpu_features();
+    cr_assert(eq(u32, features, plain_cpu_detect_features()));
+    // Cached the second time
+    cr_assert(eq(u32, plain_cpu_features(), features));
+    cr_assert(eq(u32, features & ~(PLAIN_CPU_LZCNT | PLAIN_CPU_POPCNT | PLAIN_CPU_BMI1 | PLAIN_CPU_BMI2 | PLAIN_CPU_AVX2), 0));
+    cr_assert(eq(int, PLAIN_CPU_HAS_LZCNT(), (features & PLAIN_CPU_LZCNT) != 0));
+    cr_assert(eq(int, PLAIN_CPU_HAS_POPCNT(), (features & PLAIN_CPU_POPCNT) != 0));
+    cr_assert(eq(int, PLAIN_CPU_HAS_BMI1(), (features & PLAIN_CPU_BMI1) != 0));
+    cr_assert(eq(int, PLAIN_CPU_HAS_BMI2(), (features & PLAIN_CPU_BMI2) != 0));
+    cr_assert(eq(int, PLAIN_CPU_HAS_AVX2(), (features & PLAIN_CPU_AVX2) != 0));
+}
+
+Test(cpudispatch, bit_counting) {
+    uint64_t seed = UINT64_C(0x9E3779B97F4A7C15);
+    for (int i = 0; i < 1000; i++) {
+        // xorshift
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        uint64_t val = seed >> (i % 64);
+        uint32_t val32 = (uint32_t)val;
+        cr_assert(eq(int, plain_int_popcount64_dispatch(val), plain_int_popcount64(val)));
+        cr_assert(eq(int, plain_int_popcount32_dispatch(val32), plain_int_popcount32(val32)));
+        if (val != 0) {
+            cr_assert(eq(int, plain_int_nlz64_dispatch(val), plain_int_nlz64(val)));
+        }
+        if (val32 != 0) {
+            cr_assert(eq(int, plain_int_nlz32_dispatch(val32), plain_int_nlz32(val32)));
+        }
+    }
+    cr_assert(eq(int, plain_int_nlz64_dispatch(1), 63));
+    cr_assert(eq(int, plain_int_nlz32_dispatch(UINT32_MAX), 0));
+    cr_assert(eq(int, plain_int_popcount64_dispatch(UINT64_MAX), 64));
+}
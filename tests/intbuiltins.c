@@ -30,6 +30,27 @@ Test(intbuiltins, nlz_fallback32) {
     test_nlz(func, 32);
 }
 
+Test(intbuiltins, nlz_variants32) {
+    int (*const VARIANTS[])(uint32_t) = {
+        _plain_int_nlz32_simple,
+        _plain_int_nlz32_branchless,
+        _plain_int_nlz32_debruijn,
+    };
+    for (size_t i = 0; i < sizeof(VARIANTS) / sizeof(VARIANTS[0]); i++) {
+        int (*nlz)(uint32_t) = VARIANTS[i];
+        cr_assert(eq(i32, nlz(0), 32), "variant %d", (int)i);
+        union nlz_func func = {.nlz32 = nlz};
+        test_nlz(func, 32);
+        // Every bit length, and the values on either side of it
+        for (int bit = 0; bit < 32; bit++) {
+            uint32_t pow = ((uint32_t)1) << bit;
+            cr_assert(eq(i32, nlz(pow), 31 - bit), "variant %d for 2^%d", (int)i, bit);
+            cr_assert(eq(i32, nlz(pow | (pow - 1)), 31 - bit), "variant %d for 2^%d", (int)i, bit);
+            cr_assert(eq(i32, nlz(pow - 1), bit == 0 ? 32 : 32 - bit), "variant %d for 2^%d", (int)i, bit);
+        }
+    }
+}
+
 Test(intbuiltins, nlz32) {
     int (*nlz)(uint32_t) = plain_int_nlz32;
     union nlz_func func = {.nlz32 = nlz};
@@ -44,6 +65,26 @@ Test(intbuiltins, nlz_fallback64) {
     test_nlz(func, 64);
 }
 
+Test(intbuiltins, nlz_variants64) {
+    int (*const VARIANTS[])(uint64_t) = {
+        _plain_int_nlz64_simple,
+        _plain_int_nlz64_branchless,
+        _plain_int_nlz64_debruijn,
+    };
+    for (size_t i = 0; i < sizeof(VARIANTS) / sizeof(VARIANTS[0]); i++) {
+        int (*nlz)(uint64_t) = VARIANTS[i];
+        cr_assert(eq(i32, nlz(0), 64), "variant %d", (int)i);
+        union nlz_func func = {.nlz64 = nlz};
+        test_nlz(func, 64);
+        for (int bit = 0; bit < 64; bit++) {
+            uint64_t pow = ((uint64_t)1) << bit;
+            cr_assert(eq(i32, nlz(pow), 63 - bit), "variant %d for 2^%d", (int)i, bit);
+            cr_assert(eq(i32, nlz(pow | (pow - 1)), 63 - bit), "variant %d for 2^%d", (int)i, bit);
+            cr_assert(eq(i32, nlz(pow - 1), bit == 0 ? 64 : 64 - bit), "variant %d for 2^%d", (int)i, bit);
+        }
+    }
+}
+
 Test(intbuiltins, nlz64) {
     int (*nlz)(uint64_t) = plain_int_nlz64;
     union nlz_func func = {.nlz64 = nlz};
@@ -78,9 +119,7 @@ static void assert_mul_overflowing(Int64CheckedOp target, int64_t a, int64_t b,
  * Focus on 64 bits and especially multiplication.
  */
 
-Test(intbuiltins, muls_i64_fallback) {
-    Int64CheckedOp target = _plain_int_overflowing_mul64s_fallback;
-    // quick smoke tests
+static void assert_mul_smoke(Int64CheckedOp target) {
     assert_mul_overflowing(target, INT64_MAX, 1, false);
     assert_mul_overflowing(target, INT64_MAX / 2, 2, false);
     assert_mul_overflowing(target, INT64_MAX, 0, false);
@@ -91,4 +130,372 @@ Test(intbuiltins, muls_i64_fallback) {
     assert_mul_overflowing(target, INT64_MIN, -2, true);
     assert_mul_overflowing(target, INT64_MIN / 2, -2, true);
     assert_mul_overflowing(target, INT64_MIN / 2, 2, false);
+    // Both operands larger than 31 bits
+    assert_mul_overflowing(target, INT64_C(1) << 31, INT64_C(1) << 31, false);
+    assert_mul_overflowing(target, INT64_C(1) << 32, INT64_C(1) << 31, true);
+    assert_mul_overflowing(target, -(INT64_C(1) << 32), INT64_C(1) << 31, false);
+    assert_mul_overflowing(target, -(INT64_C(1) << 32), -(INT64_C(1) << 31), true);
+    assert_mul_overflowing(target, INT64_C(3037000499), INT64_C(3037000499), false);
+    assert_mul_overflowing(target, INT64_C(3037000500), INT64_C(3037000500), true);
+    assert_mul_overflowing(target, INT64_C(3037000500), -INT64_C(3037000500), true);
+}
+
+Test(intbuiltins, muls_i64_fallback) {
+    assert_mul_smoke(_plain_int_overflowing_mul64s_fallback);
+}
+
+Test(intbuiltins, muls_i64_division) {
+    assert_mul_smoke(_plain_int_overflowing_mul64s_division);
+}
+
+Test(intbuiltins, muls_i64_fallback_matches_division) {
+    // Every pair of values near the interesting boundaries
+    const int64_t BASES[] = {0, 1, INT64_C(1) << 31, INT64_C(1) << 32, INT64_C(3037000499), INT64_C(1) << 62, INT64_MAX};
+    int64_t values[sizeof(BASES) / sizeof(BASES[0]) * 6];
+    size_t num_values = 0;
+    for (size_t i = 0; i < sizeof(BASES) / sizeof(BASES[0]); i++) {
+        for (int64_t delta = -1; delta <= 1; delta++) {
+            if ((delta > 0 && BASES[i] == INT64_MAX) || (delta < 0 && BASES[i] == 0))
+                continue;
+            values[num_values++] = BASES[i] + delta;
+            values[num_values++] = -(BASES[i] + delta) - (BASES[i] + delta == INT64_MAX);
+        }
+    }
+    for (size_t i = 0; i < num_values; i++) {
+        for (size_t j = 0; j < num_values; j++) {
+            int64_t expected_res = 0, actual_res = 0;
+            bool expected = _plain_int_overflowing_mul64s_division(values[i], values[j], &expected_res);
+            bool actual = _plain_int_overflowing_mul64s_fallback(values[i], values[j], &actual_res);
+            cr_assert(eq(int, actual, expected), "%lld * %lld", (long long)values[i], (long long)values[j]);
+            cr_assert(eq(i64, actual_res, expected_res));
+        }
+    }
+}
+
+Test(intbuiltins, muls_i64) {
+    Int64CheckedOp target = plain_int_overflowing_mul64s;
+    assert_mul_overflowing(target, INT64_MAX, 1, false);
+    assert_mul_overflowing(target, INT64_MAX, 2, true);
+    assert_mul_overflowing(target, INT64_MIN, -1, true);
+    assert_mul_overflowing(target, INT64_MIN / 2, -2, true);
+    assert_mul_overflowing(target, INT64_MIN / 2, 2, false);
+    assert_mul_overflowing(target, -(INT64_C(1) << 32), INT64_C(1) << 31, false);
+    assert_mul_overflowing(target, INT64_C(1) << 32, INT64_C(1) << 31, true);
+}
+
+static void assert_add_sub_overflowing(Int64CheckedOp add, Int64CheckedOp sub) {
+    int64_t res = 0;
+    cr_assert(not(add(INT64_MAX - 1, 1, &res)));
+    cr_assert(eq(i64, res, INT64_MAX));
+    cr_assert(add(INT64_MAX, 1, &res));
+    cr_assert(eq(i64, res, INT64_MIN));
+    cr_assert(add(INT64_MIN, -1, &res));
+    cr_assert(eq(i64, res, INT64_MAX));
+    // Results that don't fit in 32 bits
+    cr_assert(not(add(INT64_C(1) << 40, INT64_C(1) << 40, &res)));
+    cr_assert(eq(i64, res, INT64_C(1) << 41));
+    cr_assert(not(sub(INT64_MIN + 1, 1, &res)));
+    cr_assert(eq(i64, res, INT64_MIN));
+    cr_assert(sub(INT64_MIN, 1, &res));
+    cr_assert(eq(i64, res, INT64_MAX));
+    cr_assert(sub(0, INT64_MIN, &res));
+    cr_assert(eq(i64, res, INT64_MIN));
+    cr_assert(not(sub(-1, INT64_MIN, &res)));
+    cr_assert(eq(i64, res, INT64_MAX));
+}
+
+Test(intbuiltins, add_sub_i64_fallback) {
+    assert_add_sub_overflowing(_plain_int_overflowing_add64s_fallback, _plain_int_overflowing_sub64s_fallback);
+}
+
+Test(intbuiltins, add_sub_i64) {
+    assert_add_sub_overflowing(plain_int_overflowing_add64s, plain_int_overflowing_sub64s);
+}
+
+typedef uint64_t (*MulWide64uOp)(uint64_t, uint64_t, uint64_t*);
+typedef uint64_t (*MulWide64sOp)(int64_t, int64_t, int64_t*);
+
+static void assert_mul_wide64u(MulWide64uOp target, uint64_t a, uint64_t b, uint64_t expected_high, uint64_t expected_low) {
+    uint64_t high = 0;
+    uint64_t low = target(a, b, &high);
+    cr_assert(eq(u64, high, expected_high), "high half of %llu * %llu", (unsigned long long)a, (unsigned long long)b);
+    cr_assert(eq(u64, low, expected_low), "low half of %llu * %llu", (unsigned long long)a, (unsigned long long)b);
+}
+
+static void assert_mul_wide64s(MulWide64sOp target, int64_t a, int64_t b, int64_t expected_high, uint64_t expected_low) {
+    int64_t high = 0;
+    uint64_t low = target(a, b, &high);
+    cr_assert(eq(i64, high, expected_high), "high half of %lld * %lld", (long long)a, (long long)b);
+    cr_assert(eq(u64, low, expected_low), "low half of %lld * %lld", (long long)a, (long long)b);
+}
+
+static void test_mul_wide64u(MulWide64uOp target) {
+    assert_mul_wide64u(target, 0, UINT64_MAX, 0, 0);
+    assert_mul_wide64u(target, 1, UINT64_MAX, 0, UINT64_MAX);
+    assert_mul_wide64u(target, 2, UINT64_MAX, 1, UINT64_MAX - 1);
+    assert_mul_wide64u(target, UINT64_C(1) << 32, UINT64_C(1) << 32, 1, 0);
+    // (2^64 - 1)^2 = 2^128 - 2^65 + 1
+    assert_mul_wide64u(target, UINT64_MAX, UINT64_MAX, UINT64_MAX - 1, 1);
+    assert_mul_wide64u(target,
+                       UINT64_C(0x123456789ABCDEF0),
+                       UINT64_C(0xFEDCBA9876543210),
+                       UINT64_C(0x121FA00AD77D7422),
+                       UINT64_C(0x236D88FE5618CF00));
+}
+
+static void test_mul_wide64s(MulWide64sOp target) {
+    assert_mul_wide64s(target, 0, INT64_MIN, 0, 0);
+    assert_mul_wide64s(target, -1, 1, -1, UINT64_MAX);
+    assert_mul_wide64s(target, -1, -1, 0, 1);
+    assert_mul_wide64s(target, INT64_MAX, 2, 0, UINT64_MAX - 1);
+    assert_mul_wide64s(target, INT64_MIN, 2, -1, 0);
+    // (-2^63)^2 = 2^126
+    assert_mul_wide64s(target, INT64_MIN, INT64_MIN, INT64_C(1) << 62, 0);
+    // -2^63 * (2^63 - 1) = -2^126 + 2^63
+    assert_mul_wide64s(target, INT64_MIN, INT64_MAX, -(INT64_C(1) << 62), UINT64_C(1) << 63);
+    assert_mul_wide64s(target, -(INT64_C(1) << 32), INT64_C(1) << 32, -1, 0);
+}
+
+Test(intbuiltins, mul_wide64u_fallback) {
+    test_mul_wide64u(_plain_int_mul_wide64u_fallback);
+}
+
+Test(intbuiltins, mul_wide64u) {
+    test_mul_wide64u(plain_int_mul_wide64u);
+    cr_assert(eq(u64, plain_int_mul_high64u(UINT64_MAX, UINT64_MAX), UINT64_MAX - 1));
+}
+
+Test(intbuiltins, mul_wide64s_fallback) {
+    test_mul_wide64s(_plain_int_mul_wide64s_fallback);
+}
+
+Test(intbuiltins, mul_wide64s) {
+    test_mul_wide64s(plain_int_mul_wide64s);
+    cr_assert(eq(i64, plain_int_mul_high64s(INT64_MIN, 2), -1));
+}
+
+typedef bool (*Uint32CheckedOp)(uint32_t, uint32_t, uint32_t*);
+typedef bool (*Uint64CheckedOp)(uint64_t, uint64_t, uint64_t*);
+
+static void test_unsigned_overflowing32(Uint32CheckedOp add, Uint32CheckedOp sub, Uint32CheckedOp mul) {
+    uint32_t res = 0;
+    cr_assert(not(add(UINT32_MAX - 1, 1, &res)));
+    cr_assert(eq(u32, res, UINT32_MAX));
+    cr_assert(add(UINT32_MAX, 2, &res));
+    cr_assert(eq(u32, res, 1));
+    cr_assert(not(sub(7, 7, &res)));
+    cr_assert(eq(u32, res, 0));
+    cr_assert(sub(0, 1, &res));
+    cr_assert(eq(u32, res, UINT32_MAX));
+    cr_assert(not(mul(65535, 65537, &res)));
+    cr_assert(eq(u32, res, UINT32_MAX));
+    cr_assert(mul(65536, 65536, &res));
+    cr_assert(eq(u32, res, 0));
+}
+
+static void test_unsigned_overflowing64(Uint64CheckedOp add, Uint64CheckedOp sub, Uint64CheckedOp mul) {
+    uint64_t res = 0;
+    cr_assert(not(add(UINT64_MAX - 1, 1, &res)));
+    cr_assert(eq(u64, res, UINT64_MAX));
+    cr_assert(add(UINT64_MAX, 2, &res));
+    cr_assert(eq(u64, res, 1));
+    cr_assert(not(sub(UINT64_MAX, UINT64_MAX, &res)));
+    cr_assert(eq(u64, res, 0));
+    cr_assert(sub(1, 2, &res));
+    cr_assert(eq(u64, res, UINT64_MAX));
+    // 2^64 - 1 = (2^32 - 1) * (2^32 + 1)
+    cr_assert(not(mul(UINT32_MAX, UINT64_C(1) << 32 | 1, &res)));
+    cr_assert(eq(u64, res, UINT64_MAX));
+    cr_assert(mul(UINT64_C(1) << 32, UINT64_C(1) << 32, &res));
+    cr_assert(eq(u64, res, 0));
+    cr_assert(mul(UINT64_MAX, 3, &res));
+    cr_assert(eq(u64, res, UINT64_MAX - 2));
+}
+
+Test(intbuiltins, unsigned_overflowing_fallback) {
+    test_unsigned_overflowing32(_plain_int_overflowing_add32u_fallback,
+                                _plain_int_overflowing_sub32u_fallback,
+                                _plain_int_overflowing_mul32u_fallback);
+    test_unsigned_overflowing64(_plain_int_overflowing_add64u_fallback,
+                                _plain_int_overflowing_sub64u_fallback,
+                                _plain_int_overflowing_mul64u_fallback);
+}
+
+Test(intbuiltins, unsigned_overflowing) {
+    test_unsigned_overflowing32(plain_int_overflowing_add32u, plain_int_overflowing_sub32u, plain_int_overflowing_mul32u);
+    test_unsigned_overflowing64(plain_int_overflowing_add64u, plain_int_overflowing_sub64u, plain_int_overflowing_mul64u);
+}
+
+Test(intbuiltins, saturating_signed) {
+    cr_assert(eq(i32, plain_int_saturating_add32s(INT32_MAX, 1), INT32_MAX));
+    cr_assert(eq(i32, plain_int_saturating_add32s(INT32_MIN, -1), INT32_MIN));
+    cr_assert(eq(i32, plain_int_saturating_add32s(-5, 3), -2));
+    cr_assert(eq(i32, plain_int_saturating_sub32s(INT32_MIN, 1), INT32_MIN));
+    cr_assert(eq(i32, plain_int_saturating_sub32s(0, INT32_MIN), INT32_MAX));
+    cr_assert(eq(i32, plain_int_saturating_sub32s(-1, INT32_MIN), INT32_MAX));
+    cr_assert(eq(i32, plain_int_saturating_mul32s(INT32_MIN, -1), INT32_MAX));
+    cr_assert(eq(i32, plain_int_saturating_mul32s(INT32_MAX, -2), INT32_MIN));
+    cr_assert(eq(i32, plain_int_saturating_mul32s(-65536, 32768), INT32_MIN));
+    cr_assert(eq(i64, plain_int_saturating_add64s(INT64_MAX, INT64_MAX), INT64_MAX));
+    cr_assert(eq(i64, plain_int_saturating_add64s(INT64_MIN, INT64_MIN), INT64_MIN));
+    cr_assert(eq(i64, plain_int_saturating_sub64s(INT64_MAX, -1), INT64_MAX));
+    cr_assert(eq(i64, plain_int_saturating_sub64s(INT64_MIN, INT64_MAX), INT64_MIN));
+    cr_assert(eq(i64, plain_int_saturating_sub64s(7, 9), -2));
+    cr_assert(eq(i64, plain_int_saturating_mul64s(INT64_MIN, INT64_MIN), INT64_MAX));
+    cr_assert(eq(i64, plain_int_saturating_mul64s(INT64_MIN, 3), INT64_MIN));
+    cr_assert(eq(i64, plain_int_saturating_mul64s(-3, 7), -21));
+}
+
+Test(intbuiltins, saturating_unsigned) {
+    cr_assert(eq(u32, plain_int_saturating_add32u(UINT32_MAX, 1), UINT32_MAX));
+    cr_assert(eq(u32, plain_int_saturating_add32u(3, 4), 7));
+    cr_assert(eq(u32, plain_int_saturating_sub32u(3, 4), 0));
+    cr_assert(eq(u32, plain_int_saturating_sub32u(4, 3), 1));
+    cr_assert(eq(u32, plain_int_saturating_mul32u(65536, 65536), UINT32_MAX));
+    cr_assert(eq(u64, plain_int_saturating_add64u(UINT64_MAX, UINT64_MAX), UINT64_MAX));
+    cr_assert(eq(u64, plain_int_saturating_sub64u(0, UINT64_MAX), 0));
+    cr_assert(eq(u64, plain_int_saturating_mul64u(UINT64_MAX, 2), UINT64_MAX));
+    cr_assert(eq(u64, plain_int_saturating_mul64u(UINT64_C(1) << 32, UINT32_MAX), UINT64_MAX - UINT32_MAX));
+}
+
+Test(intbuiltins, generic_ops) {
+    int32_t res32s;
+    uint32_t res32u;
+    int64_t res64s;
+    uint64_t res64u;
+    cr_assert(plain_int_overflowing_add(INT32_MAX, 1, &res32s));
+    cr_assert(not(plain_int_overflowing_add(INT32_MAX, 1, &res64s)));
+    cr_assert(eq(i64, res64s, (int64_t)INT32_MAX + 1));
+    cr_assert(plain_int_overflowing_sub(0, 1, &res32u));
+    cr_assert(not(plain_int_overflowing_sub(0, 1, &res64s)));
+    cr_assert(plain_int_overflowing_mul(UINT64_MAX, 2, &res64u));
+    cr_assert(eq(u64, res64u, UINT64_MAX - 1));
+    cr_assert(eq(i32, plain_int_saturating_add((int32_t)INT32_MAX, 1), INT32_MAX));
+    cr_assert(eq(u32, plain_int_saturating_sub((uint32_t)1, 2), 0));
+    cr_assert(eq(i64, plain_int_saturating_mul((int64_t)INT64_MAX, 2), INT64_MAX));
+    cr_assert(eq(u64, plain_int_saturating_add((uint64_t)UINT64_MAX, 2), UINT64_MAX));
+}
+
+static int ref_ntz64(uint64_t x) {
+    int n = 0;
+    while (n < 64 && ((x >> n) & 1) == 0) n++;
+    return n;
+}
+
+static int ref_popcount64(uint64_t x) {
+    int n = 0;
+    for (int i = 0; i < 64; i++) n += (int)((x >> i) & 1);
+    return n;
+}
+
+static uint64_t ref_bitreverse64(uint64_t x) {
+    uint64_t res = 0;
+    for (int i = 0; i < 64; i++) {
+        res |= ((x >> i) & 1) << (63 - i);
+    }
+    return res;
+}
+
+static const uint64_t BIT_PATTERNS[] = {
+    0, 1, 2, 3, 0x80, 0xFF00, 0x12345678, 0x80000000, 0xFFFFFFFF,
+    UINT64_C(0x100000000), UINT64_C(0xDEADBEEFCAFEBABE), UINT64_C(0x8000000000000000),
+    UINT64_C(0x5555555555555555), UINT64_MAX,
+};
+
+static void check_bit_ops(uint64_t val) {
+    uint32_t val32 = (uint32_t)val;
+    cr_assert(eq(int, _plain_int_ntz64_fallback(val), ref_ntz64(val)), "ntz64 %llx", (unsigned long long)val);
+    cr_assert(eq(int, _plain_int_ntz32_fallback(val32), ref_ntz64(val32) > 32 ? 32 : ref_ntz64(val32)));
+    if (val != 0) {
+        cr_assert(eq(int, plain_int_ntz64(val), ref_ntz64(val)));
+    }
+    if (val32 != 0) {
+        cr_assert(eq(int, plain_int_ntz32(val32), ref_ntz64(val32)));
+    }
+    cr_assert(eq(int, _plain_int_popcount64_fallback(val), ref_popcount64(val)), "popcount64 %llx", (unsigned long long)val);
+    cr_assert(eq(int, plain_int_popcount64(val), ref_popcount64(val)));
+    cr_assert(eq(int, _plain_int_popcount32_fallback(val32), ref_popcount64(val32)));
+    cr_assert(eq(int, plain_int_popcount32(val32), ref_popcount64(val32)));
+    cr_assert(eq(int, _plain_int_parity64_fallback(val), ref_popcount64(val) & 1));
+    cr_assert(eq(int, plain_int_parity64(val), ref_popcount64(val) & 1));
+    cr_assert(eq(int, _plain_int_parity32_fallback(val32), ref_popcount64(val32) & 1));
+    cr_assert(eq(int, plain_int_parity32(val32), ref_popcount64(val32) & 1));
+    cr_assert(eq(u64, _plain_int_bitreverse64_fallback(val), ref_bitreverse64(val)), "bitreverse64 %llx", (unsigned long long)val);
+    cr_assert(eq(u64, plain_int_bitreverse64(val), ref_bitreverse64(val)));
+    cr_assert(eq(u32, plain_int_bitreverse32(val32), (uint32_t)(ref_bitreverse64(val32) >> 32)));
+}
+
+Test(intbuiltins, bit_ops) {
+    for (size_t i = 0; i < sizeof(BIT_PATTERNS) / sizeof(BIT_PATTERNS[0]); i++) {
+        check_bit_ops(BIT_PATTERNS[i]);
+        check_bit_ops(~BIT_PATTERNS[i]);
+    }
+    for (int shift = 0; shift < 64; shift++) {
+        check_bit_ops(UINT64_C(1) << shift);
+        check_bit_ops(UINT64_MAX << shift);
+    }
+}
+
+Test(intbuiltins, rotate) {
+    cr_assert(eq(u32, plain_int_rotl32(0x80000001u, 1), 3));
+    cr_assert(eq(u32, plain_int_rotr32(0x80000001u, 1), 0xC0000000u));
+    cr_assert(eq(u32, plain_int_rotl32(0x12345678u, 0), 0x12345678u));
+    cr_assert(eq(u32, plain_int_rotl32(0x12345678u, 32), 0x12345678u));
+    cr_assert(eq(u32, plain_int_rotl32(0x12345678u, 8), 0x34567812u));
+    cr_assert(eq(u64, plain_int_rotl64(UINT64_C(0x8000000000000001), 1), 3));
+    cr_assert(eq(u64, plain_int_rotr64(UINT64_C(0x8000000000000001), 1), UINT64_C(0xC000000000000000)));
+    cr_assert(eq(u64, plain_int_rotr64(UINT64_C(0x0123456789ABCDEF), 64), UINT64_C(0x0123456789ABCDEF)));
+    cr_assert(eq(u64, plain_int_rotr64(UINT64_C(0x0123456789ABCDEF), 4), UINT64_C(0xF0123456789ABCDE)));
+    for (unsigned int amount = 0; amount < 70; amount++) {
+        uint64_t val = UINT64_C(0xDEADBEEFCAFEBABE);
+        cr_assert(eq(u64, plain_int_rotr64(plain_int_rotl64(val, amount), amount), val));
+        cr_assert(eq(u32, plain_int_rotr32(plain_int_rotl32((uint32_t)val, amount), amount), (uint32_t)val));
+    }
+}
+
+Test(intbuiltins, next_set_bit) {
+    uint64_t remaining = UINT64_C(0x8000000100000025);
+    const int expected[] = {0, 2, 5, 32, 63};
+    size_t count = 0;
+    while (remaining != 0) {
+        int idx = plain_int_next_set_bit64(&remaining);
+        cr_assert(count < 5);
+        cr_assert(eq(int, idx, expected[count]));
+        count += 1;
+    }
+    cr_assert(eq(sz, count, 5));
+    uint32_t remaining32 = 0x80000001u;
+    cr_assert(eq(int, plain_int_next_set_bit32(&remaining32), 0));
+    cr_assert(eq(int, plain_int_next_set_bit32(&remaining32), 31));
+    cr_assert(eq(u32, remaining32, 0));
+}
+
+// These only compile if the macros are integer constant expressions
+enum {
+    NLZ32_CONST_ONE = PLAIN_NLZ32_CONST(1),
+    NLZ64_CONST_ZERO = PLAIN_NLZ64_CONST(0),
+};
+static char nlz_const_array[PLAIN_NLZ64_CONST(UINT64_C(1) << 40)];
+
+Test(intbuiltins, nlz_const) {
+    cr_assert(eq(int, NLZ32_CONST_ONE, 31));
+    cr_assert(eq(int, NLZ64_CONST_ZERO, 64));
+    cr_assert(eq(sz, sizeof(nlz_const_array), 23));
+    cr_assert(eq(int, PLAIN_NLZ32_CONST(0), 32));
+    cr_assert(eq(int, PLAIN_NLZ32_CONST(UINT32_MAX), 0));
+    cr_assert(eq(int, PLAIN_NLZ64_CONST(UINT64_MAX), 0));
+    // Check both sides of every power of two boundary against the runtime versions
+    for (int shift = 0; shift < 64; shift++) {
+        uint64_t pow2 = UINT64_C(1) << shift;
+        uint64_t vals[3] = {pow2 - 1, pow2, pow2 + 1};
+        for (int i = 0; i < 3; i++) {
+            uint64_t val = vals[i];
+            if (val != 0) {
+                cr_assert(eq(int, PLAIN_NLZ64_CONST(val), plain_int_nlz64(val)), "nlz64 %llx", (unsigned long long)val);
+            }
+            if (shift < 32 && val != 0) {
+                cr_assert(eq(int, PLAIN_NLZ32_CONST(val), plain_int_nlz32((uint32_t)val)), "nlz32 %llx", (unsigned long long)val);
+            }
+        }
+    }
 }
@@ -33,3 +33,628 @@ Test(intmath, int_pow64s) {
     assert_pow64s_overflowing(5, 60, 8512967443501092241, true);
     assert_pow64s_overflowing(5, 27, 7450580596923828125, false);
 }
+
+Test(intmath, checked_sticky_overflow) {
+    struct plain_int_checked ctx = PLAIN_INT_CHECKED_INIT;
+    uint64_t size = plain_int_checked_mul64u(&ctx, 1000, 24);
+    size = plain_int_checked_add64u(&ctx, size, 16);
+    cr_assert(eq(u64, size, 24016));
+    cr_assert(not(ctx.overflowed));
+    // Overflow in the middle of a chain
+    uint64_t huge = plain_int_checked_mul64u(&ctx, UINT64_MAX / 2, 3);
+    cr_assert(ctx.overflowed);
+    // ...stays set even after operations that don't overflow
+    (void)plain_int_checked_sub64u(&ctx, huge, 1);
+    cr_assert(eq(u64, plain_int_checked_add64u(&ctx, 1, 2), 3));
+    cr_assert(ctx.overflowed);
+}
+
+Test(intmath, checked_ops) {
+    struct plain_int_checked ctx = PLAIN_INT_CHECKED_INIT;
+    cr_assert(eq(i32, plain_int_checked_sub32s(&ctx, -7, 3), -10));
+    cr_assert(eq(u32, plain_int_checked_add32u(&ctx, UINT32_MAX - 1, 1), UINT32_MAX));
+    cr_assert(eq(i64, plain_int_checked_mul64s(&ctx, INT64_MIN / 2, 2), INT64_MIN));
+    cr_assert(eq(i64, plain_int_checked_pow64s(&ctx, 5, 27), INT64_C(7450580596923828125)));
+    cr_assert(not(ctx.overflowed));
+    cr_assert(eq(u32, plain_int_checked_sub32u(&ctx, 0, 1), UINT32_MAX));
+    cr_assert(ctx.overflowed);
+
+    ctx = (struct plain_int_checked) PLAIN_INT_CHECKED_INIT;
+    (void)plain_int_checked_pow64s(&ctx, 5, 60);
+    cr_assert(ctx.overflowed);
+    ctx = (struct plain_int_checked) PLAIN_INT_CHECKED_INIT;
+    (void)plain_int_checked_mul32s(&ctx, INT32_MIN, -1);
+    cr_assert(ctx.overflowed);
+}
+
+// These only compile if the macros are integer constant expressions
+enum {
+    ILOG2_CONST_1K = PLAIN_ILOG2_CONST(1024),
+    NEXT_POW2_CONST_1000 = PLAIN_NEXT_POW2_CONST(1000),
+};
+static char next_pow2_const_array[PLAIN_NEXT_POW2_CONST(33)];
+
+Test(intmath, const_log2) {
+    cr_assert(eq(int, ILOG2_CONST_1K, 10));
+    cr_assert(eq(int, NEXT_POW2_CONST_1000, 1024));
+    cr_assert(eq(sz, sizeof(next_pow2_const_array), 64));
+    cr_assert(eq(int, PLAIN_ILOG2_CONST(0), -1));
+    cr_assert(eq(u64, PLAIN_NEXT_POW2_CONST(0), 1));
+    cr_assert(eq(u64, PLAIN_NEXT_POW2_CONST(1), 1));
+    // Check both sides of every power of two boundary against the runtime versions
+    for (int shift = 0; shift < 64; shift++) {
+        uint64_t pow2 = UINT64_C(1) << shift;
+        cr_assert(eq(int, PLAIN_ILOG2_CONST(pow2), 63 - plain_int_nlz64(pow2)));
+        cr_assert(eq(int, PLAIN_ILOG2_CONST(pow2), shift));
+        cr_assert(eq(u64, PLAIN_NEXT_POW2_CONST(pow2), pow2));
+        cr_assert(eq(int, PLAIN_ILOG2_CONST(pow2 + 1), 63 - plain_int_nlz64(pow2 + 1)));
+        if (shift > 0) {
+            cr_assert(eq(int, PLAIN_ILOG2_CONST(pow2 - 1), 63 - plain_int_nlz64(pow2 - 1)));
+            cr_assert(eq(u64, PLAIN_NEXT_POW2_CONST(pow2 - 1), shift == 1 ? 1 : pow2));
+        }
+        if (shift < 63) {
+            cr_assert(eq(u64, PLAIN_NEXT_POW2_CONST(pow2 + 1), pow2 << 1));
+        }
+    }
+}
+
+/*
+ * Reference pow using repeated multiplication.
+ *
+ * For |base| >= 2 the magnitude only grows, so any intermediate overflow means the result overflows.
+ */
+#define REF_POW(tp, suffix) \
+    static bool ref_pow ## suffix(tp base, uint32_t exp, tp *res) { \
+        bool overflow = false; \
+        tp acc = 1; \
+        for (uint32_t i = 0; i < exp; i++) { \
+            overflow |= plain_int_overflowing_mul ## suffix(acc, base, &acc); \
+        } \
+        *res = acc; \
+        return overflow; \
+    }
+
+REF_POW(int32_t, 32s)
+REF_POW(uint32_t, 32u)
+REF_POW(int64_t, 64s)
+REF_POW(uint64_t, 64u)
+
+/*
+ * Check every pow variant against the reference for a single base & exponent.
+ */
+#define CHECK_POW(tp, suffix, min, max) \
+    static void check_pow ## suffix(tp base, uint32_t exp) { \
+        tp expected, actual; \
+        bool expected_overflow = ref_pow ## suffix(base, exp, &expected); \
+        bool actual_overflow = plain_int_pow ## suffix ## _overflowing(base, exp, &actual); \
+        cr_assert(eq(int, actual_overflow, expected_overflow), #suffix " overflow %lld**%u", (long long) base, exp); \
+        cr_assert(actual == expected, #suffix " result %lld**%u", (long long) base, exp); \
+        cr_assert(plain_int_pow ## suffix ## _wrapping(base, exp) == expected); \
+        tp saturated = expected_overflow ? (base < 0 && (exp & 1) ? min : max) : expected; \
+        cr_assert(plain_int_pow ## suffix ## _saturating(base, exp) == saturated, \
+                  #suffix " saturating %lld**%u", (long long) base, exp); \
+        struct plain_int_checked ctx = PLAIN_INT_CHECKED_INIT; \
+        tp checked = plain_int_checked_pow ## suffix(&ctx, base, exp); \
+        cr_assert(eq(int, ctx.overflowed, expected_overflow)); \
+        if (!expected_overflow) cr_assert(checked == expected); \
+    }
+
+CHECK_POW(int32_t, 32s, INT32_MIN, INT32_MAX)
+CHECK_POW(uint32_t, 32u, 0, UINT32_MAX)
+CHECK_POW(int64_t, 64s, INT64_MIN, INT64_MAX)
+CHECK_POW(uint64_t, 64u, 0, UINT64_MAX)
+
+/*
+ * Check small bases, and the bases on either side of where overflow starts, for every exponent.
+ *
+ * The boundary is found with a binary search over the reference (in the direction of `sign`).
+ */
+#define CHECK_POW_BOUNDARIES(tp, suffix, bits, sign) do { \
+        for (uint32_t exp = 0; exp < (bits) + 3; exp++) { \
+            for (int small = -3; small <= 3; small++) { \
+                check_pow ## suffix((tp) (small * (sign)), exp); \
+            } \
+            if (exp < 2) continue; \
+            tp lo = 0, hi = (tp) ((sign) * 2), ignored; \
+            while (!ref_pow ## suffix(hi, exp, &ignored)) { \
+                lo = hi; \
+                hi = (tp) (hi * 2); \
+            } \
+            while ((tp) ((hi - lo) * (sign)) > 1) { \
+                tp mid = (tp) (lo + (hi - lo) / 2); \
+                if (ref_pow ## suffix(mid, exp, &ignored)) hi = mid; else lo = mid; \
+            } \
+            check_pow ## suffix((tp) (lo - (sign)), exp); \
+            check_pow ## suffix(lo, exp); \
+            check_pow ## suffix(hi, exp); \
+            check_pow ## suffix((tp) (hi + (sign)), exp); \
+        } \
+    } while (false)
+
+Test(intmath, pow_family) {
+    CHECK_POW_BOUNDARIES(int32_t, 32s, 32, 1);
+    CHECK_POW_BOUNDARIES(int32_t, 32s, 32, -1);
+    CHECK_POW_BOUNDARIES(uint32_t, 32u, 32, 1u);
+    CHECK_POW_BOUNDARIES(int64_t, 64s, 64, 1);
+    CHECK_POW_BOUNDARIES(int64_t, 64s, 64, -1);
+    CHECK_POW_BOUNDARIES(uint64_t, 64u, 64, 1u);
+    // Exactly the minimum value
+    cr_assert(eq(i64, plain_int_pow64s_saturating(-2, 63), INT64_MIN));
+    cr_assert(eq(i64, plain_int_pow64s_saturating(2, 63), INT64_MAX));
+    cr_assert(eq(i32, plain_int_pow32s_saturating(-2, 31), INT32_MIN));
+    cr_assert(eq(i64, plain_int_pow64s_saturating(-2097152, 3), INT64_MIN));
+    cr_assert(eq(i64, plain_int_pow64s_saturating(-2097153, 3), INT64_MIN));
+    cr_assert(eq(i64, plain_int_pow64s_saturating(-3, 64), INT64_MAX));
+    // Huge exponents only fit for -1, 0 and 1
+    cr_assert(eq(i64, plain_int_pow64s_saturating(-1, UINT32_MAX), -1));
+    cr_assert(eq(u64, plain_int_pow64u_saturating(0, UINT32_MAX), 0));
+    cr_assert(eq(u32, plain_int_pow32u_saturating(2, UINT32_MAX), UINT32_MAX));
+}
+
+/*
+ * Compare the addition chains against the loop, for an exponent that must be a literal.
+ */
+#define CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, exp) do { \
+        tp expected, actual; \
+        bool expected_overflow = plain_int_pow ## suffix ## _overflowing(base, exp, &expected); \
+        bool actual_overflow = PLAIN_INT_POW ## SUFFIX ## _OVERFLOWING_CONST(base, exp, &actual); \
+        cr_assert(eq(int, actual_overflow, expected_overflow), #suffix " overflow %lld**%d", (long long) base, exp); \
+        cr_assert(actual == expected, #suffix " result %lld**%d", (long long) base, exp); \
+    } while (false)
+
+#define CHECK_POW_CHAINS(tp, suffix, SUFFIX) \
+    static void check_pow_chains ## suffix(tp base) { \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 0); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 1); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 2); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 3); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 4); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 5); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 6); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 7); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 8); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 9); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 10); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 11); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 12); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 13); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 14); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 15); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 16); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 17); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 18); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 19); \
+        CHECK_POW_CHAIN(tp, suffix, SUFFIX, base, 20); \
+    }
+
+CHECK_POW_CHAINS(int32_t, 32s, 32S)
+CHECK_POW_CHAINS(uint32_t, 32u, 32U)
+CHECK_POW_CHAINS(int64_t, 64s, 64S)
+CHECK_POW_CHAINS(uint64_t, 64u, 64U)
+
+Test(intmath, pow_const) {
+    // Powers of two (and their neighbours) hit the exact boundaries like (-2)^63,
+    // the rest are near the roots of the maximum for some exponent
+    static const int64_t others[] = {0, 3, 5, 7, 10, 13, 21, 46340, 55108, 2097151, INT64_C(3037000499)};
+    for (int shift = 0; shift < 63; shift++) {
+        int64_t pow2 = INT64_C(1) << shift;
+        for (int64_t delta = -1; delta <= 1; delta++) {
+            int64_t base = pow2 + delta;
+            check_pow_chains64s(base);
+            check_pow_chains64s(-base);
+            check_pow_chains64u((uint64_t) base);
+            check_pow_chains32s((int32_t) base);
+            check_pow_chains32s((int32_t) -base);
+            check_pow_chains32u((uint32_t) base);
+        }
+    }
+    for (size_t i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+        for (int64_t delta = -1; delta <= 1; delta++) {
+            int64_t base = others[i] + delta;
+            check_pow_chains64s(base);
+            check_pow_chains64s(-base);
+            check_pow_chains64u((uint64_t) base);
+            check_pow_chains32s((int32_t) base);
+            check_pow_chains32u((uint32_t) base);
+        }
+    }
+    // The exponent may be a macro
+#define TEST_EXPONENT 18
+    int64_t res;
+    cr_assert(not(PLAIN_INT_POW64S_OVERFLOWING_CONST(10, TEST_EXPONENT, &res)));
+    cr_assert(eq(i64, res, INT64_C(1000000000000000000)));
+#undef TEST_EXPONENT
+}
+
+static int ref_ilog10(uint64_t val) {
+    int res = -1;
+    while (val != 0) {
+        val /= 10;
+        res += 1;
+    }
+    return res;
+}
+
+static void check_logs(uint64_t val) {
+    int expected_log2 = 63 - PLAIN_NLZ64_CONST(val);
+    int expected_log10 = ref_ilog10(val);
+    int expected_digits = val == 0 ? 1 : expected_log10 + 1;
+    cr_assert(eq(int, plain_int_ilog2_64u(val), expected_log2), "ilog2(%llu)", (unsigned long long) val);
+    cr_assert(eq(int, plain_int_ilog10_64u(val), expected_log10), "ilog10(%llu)", (unsigned long long) val);
+    cr_assert(eq(int, plain_int_decimal_digits64u(val), expected_digits), "digits(%llu)", (unsigned long long) val);
+    if (val <= INT64_MAX) {
+        int64_t sval = (int64_t) val;
+        cr_assert(eq(int, plain_int_ilog2_64s(sval), expected_log2));
+        cr_assert(eq(int, plain_int_ilog10_64s(sval), expected_log10));
+        cr_assert(eq(int, plain_int_decimal_digits64s(sval), expected_digits));
+        cr_assert(eq(int, plain_int_decimal_digits64s(-sval), expected_digits));
+        if (sval != 0) {
+            cr_assert(eq(int, plain_int_ilog2_64s(-sval), -1));
+            cr_assert(eq(int, plain_int_ilog10_64s(-sval), -1));
+        }
+    }
+    if (val <= UINT32_MAX) {
+        uint32_t val32 = (uint32_t) val;
+        cr_assert(eq(int, plain_int_ilog2_32u(val32), expected_log2));
+        cr_assert(eq(int, plain_int_ilog10_32u(val32), expected_log10), "ilog10(%u)", val32);
+        cr_assert(eq(int, plain_int_decimal_digits32u(val32), expected_digits));
+    }
+    if (val <= INT32_MAX) {
+        int32_t sval32 = (int32_t) val;
+        cr_assert(eq(int, plain_int_ilog2_32s(sval32), expected_log2));
+        cr_assert(eq(int, plain_int_ilog10_32s(sval32), expected_log10));
+        cr_assert(eq(int, plain_int_decimal_digits32s(sval32), expected_digits));
+        cr_assert(eq(int, plain_int_decimal_digits32s(-sval32), expected_digits));
+    }
+}
+
+Test(intmath, logs) {
+    check_logs(0);
+    // Both sides of every power of two & power of ten
+    for (int shift = 0; shift < 64; shift++) {
+        uint64_t pow2 = UINT64_C(1) << shift;
+        check_logs(pow2 - 1);
+        check_logs(pow2);
+        check_logs(pow2 + 1);
+    }
+    uint64_t pow10 = 1;
+    for (int exp = 0; exp <= 19; exp++) {
+        check_logs(pow10 - 1);
+        check_logs(pow10);
+        check_logs(pow10 + 1);
+        if (exp < 19) pow10 *= 10;
+    }
+    check_logs(UINT64_MAX);
+    check_logs(UINT32_MAX);
+    // The minimum values don't have a positive counterpart
+    cr_assert(eq(int, plain_int_decimal_digits32s(INT32_MIN), 10));
+    cr_assert(eq(int, plain_int_decimal_digits64s(INT64_MIN), 19));
+    cr_assert(eq(int, plain_int_ilog2_64s(INT64_MIN), -1));
+    cr_assert(eq(int, plain_int_ilog10_32s(INT32_MIN), -1));
+}
+
+/*
+ * Checks every divider operation against the `/` and `%` operators.
+ *
+ * The narrower types use the low bits of the same divisor & numerator.
+ */
+static void check_dividers(uint64_t divisor, const uint64_t *numerators, size_t n) {
+    uint32_t divisor32 = (uint32_t) divisor;
+    struct plain_int_divider64u div64u = plain_int_divider64u_new(divisor);
+    struct plain_int_divider64s div64s = plain_int_divider64s_new((int64_t) divisor);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t val = numerators[i];
+        cr_assert(eq(u64, plain_int_divider64u_div(&div64u, val), val / divisor),
+                  "%llu / %llu", (unsigned long long) val, (unsigned long long) divisor);
+        cr_assert(eq(u64, plain_int_divider64u_mod(&div64u, val), val % divisor));
+        cr_assert(eq(int, plain_int_divider64u_divisible(&div64u, val), val % divisor == 0));
+        int64_t sval = (int64_t) val, sdivisor = (int64_t) divisor;
+        if (sval != INT64_MIN || sdivisor != -1) {
+            cr_assert(eq(i64, plain_int_divider64s_div(&div64s, sval), sval / sdivisor),
+                      "%lld / %lld", (long long) sval, (long long) sdivisor);
+            cr_assert(eq(i64, plain_int_divider64s_mod(&div64s, sval), sval % sdivisor));
+            cr_assert(eq(int, plain_int_divider64s_divisible(&div64s, sval), sval % sdivisor == 0));
+        }
+    }
+    if (divisor32 == 0) return;
+    struct plain_int_divider32u div32u = plain_int_divider32u_new(divisor32);
+    struct plain_int_divider32s div32s = plain_int_divider32s_new((int32_t) divisor32);
+    for (size_t i = 0; i < n; i++) {
+        uint32_t val32 = (uint32_t) numerators[i];
+        cr_assert(eq(u32, plain_int_divider32u_div(&div32u, val32), val32 / divisor32),
+                  "%u / %u", val32, divisor32);
+        cr_assert(eq(u32, plain_int_divider32u_mod(&div32u, val32), val32 % divisor32));
+        cr_assert(eq(int, plain_int_divider32u_divisible(&div32u, val32), val32 % divisor32 == 0));
+        int32_t sval32 = (int32_t) val32, sdivisor32 = (int32_t) divisor32;
+        if (sval32 != INT32_MIN || sdivisor32 != -1) {
+            cr_assert(eq(i32, plain_int_divider32s_div(&div32s, sval32), sval32 / sdivisor32),
+                      "%d / %d", sval32, sdivisor32);
+            cr_assert(eq(i32, plain_int_divider32s_mod(&div32s, sval32), sval32 % sdivisor32));
+            cr_assert(eq(int, plain_int_divider32s_divisible(&div32s, sval32), sval32 % sdivisor32 == 0));
+        }
+    }
+}
+
+Test(intmath, dividers) {
+    enum { NUM_RANDOM = 64 };
+    uint64_t numerators[3 * 64 + 3 * 32 + NUM_RANDOM];
+    size_t n = 0;
+    // Around every power of two, for both widths
+    for (int shift = 0; shift < 64; shift++) {
+        uint64_t pow2 = UINT64_C(1) << shift;
+        numerators[n++] = pow2 - 1;
+        numerators[n++] = pow2;
+        numerators[n++] = pow2 + 1;
+    }
+    for (int shift = 0; shift < 32; shift++) {
+        uint64_t pow2 = UINT64_C(1) << shift;
+        numerators[n++] = UINT64_MAX - pow2;
+        numerators[n++] = UINT32_MAX - pow2;
+        numerators[n++] = pow2 * 3;
+    }
+    // xorshift
+    uint64_t seed = 0xD1CE;
+    for (int i = 0; i < NUM_RANDOM; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        numerators[n++] = seed >> (seed % 64);
+    }
+    // Small divisors, powers of two (and their neighbors), and both ends of the range
+    for (uint64_t divisor = 1; divisor <= 1000; divisor++) {
+        check_dividers(divisor, numerators, n);
+        check_dividers(0 - divisor, numerators, n);
+        check_dividers(UINT32_MAX - divisor + 1, numerators, n);
+    }
+    for (int shift = 1; shift < 64; shift++) {
+        uint64_t pow2 = UINT64_C(1) << shift;
+        check_dividers(pow2 - 1, numerators, n);
+        check_dividers(pow2, numerators, n);
+        check_dividers(pow2 + 1, numerators, n);
+        check_dividers(pow2 | (pow2 >> 1), numerators, n);
+    }
+    for (int i = 0; i < NUM_RANDOM; i++) {
+        check_dividers(numerators[n - 1 - i] | 1, numerators, n);
+    }
+}
+
+Test(intmath, divider_edge_cases) {
+    // Dividing the minimum value by -1 wraps around, instead of being undefined
+    struct plain_int_divider32s neg_one32 = plain_int_divider32s_new(-1);
+    cr_assert(eq(i32, plain_int_divider32s_div(&neg_one32, INT32_MIN), INT32_MIN));
+    cr_assert(eq(i32, plain_int_divider32s_mod(&neg_one32, INT32_MIN), 0));
+    struct plain_int_divider64s neg_one64 = plain_int_divider64s_new(-1);
+    cr_assert(eq(i64, plain_int_divider64s_div(&neg_one64, INT64_MIN), INT64_MIN));
+    cr_assert(eq(i64, plain_int_divider64s_mod(&neg_one64, INT64_MIN), 0));
+    cr_assert(plain_int_divider64s_divisible(&neg_one64, INT64_MIN));
+    struct plain_int_divider64s min64 = plain_int_divider64s_new(INT64_MIN);
+    cr_assert(eq(i64, plain_int_divider64s_div(&min64, INT64_MIN), 1));
+    cr_assert(eq(i64, plain_int_divider64s_div(&min64, INT64_MAX), 0));
+    cr_assert(plain_int_divider64s_divisible(&min64, INT64_MIN));
+    cr_assert(not(plain_int_divider64s_divisible(&min64, INT64_MIN / 2)));
+}
+
+/*
+ * Checks the batch versions against the scalar ones (which are checked above).
+ */
+#define CHECK_DIVIDER_BATCH(tp, suffix, divisor, values, len) \
+    do { \
+        struct plain_int_divider ## suffix divider = plain_int_divider ## suffix ## _new((tp) (divisor)); \
+        tp out[len]; \
+        plain_int_divider ## suffix ## _div_batch(&divider, values, out, len); \
+        for (int i = 0; i < len; i++) { \
+            cr_assert(eq(u64, (uint64_t) out[i], (uint64_t) plain_int_divider ## suffix ## _div(&divider, values[i])), \
+                      #suffix " div by %lld", (long long) (tp) (divisor)); \
+        } \
+        plain_int_divider ## suffix ## _mod_batch(&divider, values, out, len); \
+        for (int i = 0; i < len; i++) { \
+            cr_assert(eq(u64, (uint64_t) out[i], (uint64_t) plain_int_divider ## suffix ## _mod(&divider, values[i])), \
+                      #suffix " mod by %lld", (long long) (tp) (divisor)); \
+        } \
+    } while (false)
+
+Test(intmath, divider_batch) {
+    // Longer than a block, so the remainder is computed in pieces
+    enum { LEN = 600 };
+    static uint32_t values32u[LEN];
+    static uint64_t values64u[LEN];
+    static int32_t values32s[LEN];
+    static int64_t values64s[LEN];
+    uint64_t seed = 0xBA7C4;
+    for (int i = 0; i < LEN; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        uint64_t val = seed >> (seed % 64);
+        values32u[i] = (uint32_t) val;
+        values64u[i] = val;
+        values32s[i] = (int32_t) (i % 2 ? val : 0 - val);
+        values64s[i] = (int64_t) (i % 2 ? val : 0 - val);
+    }
+    values32s[0] = INT32_MIN;
+    values64s[0] = INT64_MIN;
+    // Powers of two, with & without the extra bit, and both signs
+    static const int64_t divisors[] = {1, 2, 3, 7, 641, 1000, 1 << 20, INT32_MAX, -1, -3, -7, -641, -1024, INT32_MIN};
+    for (size_t i = 0; i < sizeof(divisors) / sizeof(divisors[0]); i++) {
+        int64_t divisor = divisors[i];
+        CHECK_DIVIDER_BATCH(int32_t, 32s, divisor, values32s, LEN);
+        CHECK_DIVIDER_BATCH(int64_t, 64s, divisor, values64s, LEN);
+        CHECK_DIVIDER_BATCH(int64_t, 64s, divisor * INT64_C(1000003), values64s, LEN);
+        if (divisor > 0) {
+            CHECK_DIVIDER_BATCH(uint32_t, 32u, divisor, values32u, LEN);
+            CHECK_DIVIDER_BATCH(uint64_t, 64u, divisor, values64u, LEN);
+            CHECK_DIVIDER_BATCH(uint64_t, 64u, (uint64_t) divisor << 32, values64u, LEN);
+        }
+    }
+    // In place
+    struct plain_int_divider64s div64s = plain_int_divider64s_new(-1000);
+    int64_t expected[LEN];
+    for (int i = 0; i < LEN; i++) expected[i] = values64s[i] % -1000;
+    plain_int_divider64s_mod_batch(&div64s, values64s, values64s, LEN);
+    for (int i = 0; i < LEN; i++) cr_assert(eq(i64, values64s[i], expected[i]));
+}
+
+static void assert_mul_div64u(
+    uint64_t a, uint64_t b, uint64_t c,
+    enum plain_int_rounding rounding,
+    uint64_t expected_res,
+    bool expected_overflow
+) {
+    uint64_t actual_res = 0;
+    bool actual_overflow = plain_int_mul_div64u(a, b, c, rounding, &actual_res);
+    cr_assert(eq(int, actual_overflow, expected_overflow),
+              "Expected overflow = %d for %llu * %llu / %llu (rounding %d)",
+              expected_overflow, (unsigned long long) a, (unsigned long long) b, (unsigned long long) c, rounding);
+    cr_assert(eq(u64, actual_res, expected_res),
+              "Expected %llu * %llu / %llu = %llu (rounding %d)",
+              (unsigned long long) a, (unsigned long long) b, (unsigned long long) c,
+              (unsigned long long) expected_res, rounding);
+}
+
+static void assert_mul_div64s(
+    int64_t a, int64_t b, int64_t c,
+    enum plain_int_rounding rounding,
+    int64_t expected_res,
+    bool expected_overflow
+) {
+    int64_t actual_res = 0;
+    bool actual_overflow = plain_int_mul_div64s(a, b, c, rounding, &actual_res);
+    cr_assert(eq(int, actual_overflow, expected_overflow),
+              "Expected overflow = %d for %lld * %lld / %lld (rounding %d)",
+              expected_overflow, (long long) a, (long long) b, (long long) c, rounding);
+    cr_assert(eq(i64, actual_res, expected_res),
+              "Expected %lld * %lld / %lld = %lld (rounding %d)",
+              (long long) a, (long long) b, (long long) c, (long long) expected_res, rounding);
+}
+
+Test(intmath, mul_div) {
+    // The product overflows, but the result fits
+    assert_mul_div64u(UINT64_MAX, UINT64_MAX, UINT64_MAX, PLAIN_INT_ROUND_TOWARD_ZERO, UINT64_MAX, false);
+    assert_mul_div64u(UINT64_C(1) << 63, 4, 8, PLAIN_INT_ROUND_TOWARD_ZERO, UINT64_C(1) << 62, false);
+    // 10^12 ticks of a 24 MHz clock, in nanoseconds
+    uint64_t ticks = UINT64_C(1000000000000);
+    assert_mul_div64u(ticks, 1000000000, 24000000, PLAIN_INT_ROUND_DOWN, UINT64_C(41666666666666), false);
+    assert_mul_div64u(ticks, 1000000000, 24000000, PLAIN_INT_ROUND_UP, UINT64_C(41666666666667), false);
+    assert_mul_div64u(ticks, 1000000000, 24000000, PLAIN_INT_ROUND_NEAREST, UINT64_C(41666666666667), false);
+    // The result overflows, and wraps around
+    assert_mul_div64u(UINT64_MAX, 3, 2, PLAIN_INT_ROUND_TOWARD_ZERO, UINT64_MAX / 2 - 1, true);
+    assert_mul_div64u(UINT64_MAX, UINT64_MAX, UINT64_MAX - 1, PLAIN_INT_ROUND_UP, 1, true);
+    // 31 * 1190112520884487201 = 2^65 - 1, so rounding up the half overflows
+    assert_mul_div64u(31, UINT64_C(1190112520884487201), 2, PLAIN_INT_ROUND_DOWN, UINT64_MAX, false);
+    assert_mul_div64u(31, UINT64_C(1190112520884487201), 2, PLAIN_INT_ROUND_UP, 0, true);
+    assert_mul_div64u(31, UINT64_C(1190112520884487201), 2, PLAIN_INT_ROUND_NEAREST, 0, true);
+    // Rounding modes, for 7 / 2 = 3.5 and 5 / 4 = 1.25
+    assert_mul_div64u(7, 1, 2, PLAIN_INT_ROUND_TOWARD_ZERO, 3, false);
+    assert_mul_div64u(7, 1, 2, PLAIN_INT_ROUND_DOWN, 3, false);
+    assert_mul_div64u(7, 1, 2, PLAIN_INT_ROUND_UP, 4, false);
+    assert_mul_div64u(7, 1, 2, PLAIN_INT_ROUND_NEAREST, 4, false);
+    assert_mul_div64u(5, 1, 4, PLAIN_INT_ROUND_NEAREST, 1, false);
+    assert_mul_div64u(5, 3, 4, PLAIN_INT_ROUND_NEAREST, 4, false);
+    // Negative results round in the other direction
+    assert_mul_div64s(-7, 1, 2, PLAIN_INT_ROUND_TOWARD_ZERO, -3, false);
+    assert_mul_div64s(-7, 1, 2, PLAIN_INT_ROUND_DOWN, -4, false);
+    assert_mul_div64s(7, 1, -2, PLAIN_INT_ROUND_UP, -3, false);
+    assert_mul_div64s(7, -1, 2, PLAIN_INT_ROUND_NEAREST, -4, false);
+    assert_mul_div64s(-7, -1, 2, PLAIN_INT_ROUND_DOWN, 3, false);
+    assert_mul_div64s(-7, 1, -2, PLAIN_INT_ROUND_UP, 4, false);
+    assert_mul_div64s(INT64_MAX, 3, 4, PLAIN_INT_ROUND_TOWARD_ZERO, INT64_C(6917529027641081855), false);
+    assert_mul_div64s(INT64_MAX, -3, 4, PLAIN_INT_ROUND_DOWN, INT64_C(-6917529027641081856), false);
+    // The minimum value has no positive counterpart
+    assert_mul_div64s(INT64_MIN, INT64_MIN, INT64_MIN, PLAIN_INT_ROUND_TOWARD_ZERO, INT64_MIN, false);
+    assert_mul_div64s(INT64_MIN, -1, -1, PLAIN_INT_ROUND_TOWARD_ZERO, INT64_MIN, false);
+    assert_mul_div64s(INT64_MIN, 1, -1, PLAIN_INT_ROUND_TOWARD_ZERO, INT64_MIN, true);
+    assert_mul_div64s(INT64_MAX, INT64_MAX, INT64_MAX, PLAIN_INT_ROUND_UP, INT64_MAX, false);
+    assert_mul_div64s(INT64_MAX, INT64_MAX, -INT64_MAX, PLAIN_INT_ROUND_UP, -INT64_MAX, false);
+}
+
+/*
+ * Compares two 128 bit values, stored as (high, low) pairs.
+ */
+static int cmp128(uint64_t a_high, uint64_t a_low, uint64_t b_high, uint64_t b_low) {
+    if (a_high != b_high) return a_high < b_high ? -1 : 1;
+    if (a_low != b_low) return a_low < b_low ? -1 : 1;
+    return 0;
+}
+
+Test(intmath, mul_div_random) {
+    uint64_t seed = 0x3D1F;
+    for (int i = 0; i < 20000; i++) {
+        uint64_t values[3];
+        for (int j = 0; j < 3; j++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            values[j] = seed >> (seed % 64);
+        }
+        uint64_t a = values[0], b = values[1], c = values[2] | 1;
+        uint64_t down, up;
+        bool overflow = plain_int_mul_div64u(a, b, c, PLAIN_INT_ROUND_DOWN, &down);
+        bool overflow_up = plain_int_mul_div64u(a, b, c, PLAIN_INT_ROUND_UP, &up);
+        uint64_t product_high, product_low = plain_int_mul_wide64u(a, b, &product_high);
+        if (overflow) {
+            // The product is at least 2^64 * c
+            cr_assert(overflow_up);
+            cr_assert(ge(u64, product_high, c));
+            continue;
+        }
+        // down * c <= a * b < (down + 1) * c
+        uint64_t low_high, low_low = plain_int_mul_wide64u(down, c, &low_high);
+        cr_assert(le(int, cmp128(low_high, low_low, product_high, product_low), 0));
+        if (down != UINT64_MAX) {
+            uint64_t next_high, next_low = plain_int_mul_wide64u(down + 1, c, &next_high);
+            cr_assert(gt(int, cmp128(next_high, next_low, product_high, product_low), 0));
+        }
+        // Rounding up only differs if the division is inexact
+        bool exact = cmp128(low_high, low_low, product_high, product_low) == 0;
+        if (!overflow_up) cr_assert(eq(u64, up, down + !exact));
+        // Small products can be checked directly against `/`
+        if (product_high == 0) {
+            int64_t signed_res;
+            int64_t sa = (int64_t) (a & INT32_MAX), sb = -(int64_t) (b & INT32_MAX), sc = (int64_t) (c & INT32_MAX) | 1;
+            cr_assert(not(plain_int_mul_div64s(sa, sb, sc, PLAIN_INT_ROUND_TOWARD_ZERO, &signed_res)));
+            cr_assert(eq(i64, signed_res, sa * sb / sc));
+        }
+    }
+}
+
+Test(intmath, fixed_point) {
+    int32_t res32;
+    // Q16.16: 1.5 * 2.25 = 3.375
+    cr_assert(not(plain_int_mul_q32s(3 << 15, 9 << 14, 16, PLAIN_INT_ROUND_NEAREST, &res32)));
+    cr_assert(eq(i32, res32, 27 << 13));
+    cr_assert(not(plain_int_mul_q32s(-(3 << 15), 9 << 14, 16, PLAIN_INT_ROUND_NEAREST, &res32)));
+    cr_assert(eq(i32, res32, -(27 << 13)));
+    // 2^-16 * 2^-16 is too small to represent
+    cr_assert(not(plain_int_mul_q32s(1, 1, 16, PLAIN_INT_ROUND_TOWARD_ZERO, &res32)));
+    cr_assert(eq(i32, res32, 0));
+    cr_assert(not(plain_int_mul_q32s(1, 1, 16, PLAIN_INT_ROUND_UP, &res32)));
+    cr_assert(eq(i32, res32, 1));
+    cr_assert(not(plain_int_mul_q32s(-1, 1, 16, PLAIN_INT_ROUND_DOWN, &res32)));
+    cr_assert(eq(i32, res32, -1));
+    cr_assert(not(plain_int_mul_q32s(-1, 1, 16, PLAIN_INT_ROUND_UP, &res32)));
+    cr_assert(eq(i32, res32, 0));
+    // Exactly half of the smallest unit rounds away from zero
+    cr_assert(not(plain_int_mul_q32s(1 << 8, 1 << 7, 16, PLAIN_INT_ROUND_NEAREST, &res32)));
+    cr_assert(eq(i32, res32, 1));
+    cr_assert(not(plain_int_mul_q32s(-(1 << 8), 1 << 7, 16, PLAIN_INT_ROUND_NEAREST, &res32)));
+    cr_assert(eq(i32, res32, -1));
+    cr_assert(plain_int_mul_q32s(INT32_MAX, INT32_MAX, 16, PLAIN_INT_ROUND_NEAREST, &res32));
+    uint32_t res32u;
+    cr_assert(not(plain_int_mul_q32u(UINT32_MAX, 1u << 31, 31, PLAIN_INT_ROUND_TOWARD_ZERO, &res32u)));
+    cr_assert(eq(u32, res32u, UINT32_MAX));
+    cr_assert(plain_int_mul_q32u(UINT32_MAX, UINT32_MAX, 31, PLAIN_INT_ROUND_TOWARD_ZERO, &res32u));
+    // Q32.32, where the product needs 128 bits
+    int64_t res64;
+    cr_assert(not(plain_int_mul_q64s(INT64_C(3) << 32, -(INT64_C(5) << 32), 32, PLAIN_INT_ROUND_NEAREST, &res64)));
+    cr_assert(eq(i64, res64, -(INT64_C(15) << 32)));
+    cr_assert(plain_int_mul_q64s(INT64_C(1) << 48, INT64_C(1) << 48, 32, PLAIN_INT_ROUND_NEAREST, &res64));
+    cr_assert(eq(i64, res64, 0));
+    cr_assert(plain_int_mul_q64s(INT64_MIN, -1, 0, PLAIN_INT_ROUND_NEAREST, &res64));
+    cr_assert(eq(i64, res64, INT64_MIN));
+    cr_assert(not(plain_int_mul_q64s(INT64_MIN, INT64_C(1) << 62, 62, PLAIN_INT_ROUND_NEAREST, &res64)));
+    cr_assert(eq(i64, res64, INT64_MIN));
+    uint64_t res64u;
+    cr_assert(plain_int_mul_q64u(UINT64_MAX, UINT64_MAX, 63, PLAIN_INT_ROUND_DOWN, &res64u));
+    cr_assert(not(plain_int_mul_q64u(UINT64_MAX, UINT64_C(1) << 63, 63, PLAIN_INT_ROUND_UP, &res64u)));
+    cr_assert(eq(u64, res64u, UINT64_MAX));
+}
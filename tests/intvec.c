@@ -0,0 +1,201 @@
+#include "plain/intvec.h"
+
+#include <criterion/criterion.h>
+#include <criterion/new/assert.h>
+
+// Long enough to use full vectors, with leftover elements for the scalar tail
+#define LEN 37
+
+typedef bool (*Int32CheckedOp)(int32_t, int32_t, int32_t*);
+typedef bool (*Int64CheckedOp)(int64_t, int64_t, int64_t*);
+
+/*
+ * Fill the inputs with small values, and a pair that overflows at `overflow_idx` (and 3 after it)
+ */
+static void fill_inputs32(int32_t *first, int32_t *second, size_t overflow_idx, const int32_t overflow_pair[2]) {
+    for (size_t i = 0; i < LEN; i++) {
+        first[i] = (int32_t) (i * 7919) - 100000;
+        second[i] = (int32_t) (i * 31) - 500;
+    }
+    if (overflow_idx < LEN) {
+        first[overflow_idx] = overflow_pair[0];
+        second[overflow_idx] = overflow_pair[1];
+        // Overflow more than once, only the first one should be reported
+        if (overflow_idx + 3 < LEN) {
+            first[overflow_idx + 3] = overflow_pair[0];
+            second[overflow_idx + 3] = overflow_pair[1];
+        }
+    }
+}
+
+/*
+ * Fill the inputs with small values, and a pair that overflows at `overflow_idx` (and 3 after it)
+ */
+static void fill_inputs64(int64_t *first, int64_t *second, size_t overflow_idx, const int64_t overflow_pair[2]) {
+    for (size_t i = 0; i < LEN; i++) {
+        first[i] = (int64_t) (i * 104729) - 1000000;
+        second[i] = (int64_t) (i * 131) - 5000;
+    }
+    if (overflow_idx < LEN) {
+        first[overflow_idx] = overflow_pair[0];
+        second[overflow_idx] = overflow_pair[1];
+        // Overflow more than once, only the first one should be reported
+        if (overflow_idx + 3 < LEN) {
+            first[overflow_idx + 3] = overflow_pair[0];
+            second[overflow_idx + 3] = overflow_pair[1];
+        }
+    }
+}
+
+static void check_elementwise32(
+    const char *name,
+    size_t (*target)(const int32_t*, const int32_t*, int32_t*, size_t),
+    Int32CheckedOp scalar,
+    int32_t overflow_first,
+    int32_t overflow_second
+) {
+    const int32_t overflow_pair[2] = {overflow_first, overflow_second};
+    int32_t first[LEN], second[LEN], out[LEN];
+    // Every possible overflow position (including none), and every length
+    for (size_t overflow_idx = 0; overflow_idx <= LEN; overflow_idx++) {
+        for (size_t n = 0; n <= LEN; n++) {
+            fill_inputs32(first, second, overflow_idx, overflow_pair);
+            size_t expected_idx = n;
+            size_t actual_idx = target(first, second, out, n);
+            for (size_t i = 0; i < n; i++) {
+                int32_t expected;
+                if (scalar(first[i], second[i], &expected) && expected_idx == n)
+                    expected_idx = i;
+                cr_assert(eq(i32, out[i], expected), "%s: element %zu of %zu", name, i, n);
+            }
+            cr_assert(eq(sz, actual_idx, expected_idx), "%s: overflow at %zu of %zu", name, overflow_idx, n);
+            cr_assert(eq(sz, expected_idx, overflow_idx < n ? overflow_idx : n), "%s: bad test inputs", name);
+        }
+    }
+    // In place
+    fill_inputs32(first, second, 5, overflow_pair);
+    cr_assert(eq(sz, target(first, second, first, LEN), 5), "%s: in place", name);
+}
+
+static void check_elementwise64(
+    const char *name,
+    size_t (*target)(const int64_t*, const int64_t*, int64_t*, size_t),
+    Int64CheckedOp scalar,
+    int64_t overflow_first,
+    int64_t overflow_second
+) {
+    const int64_t overflow_pair[2] = {overflow_first, overflow_second};
+    int64_t first[LEN], second[LEN], out[LEN];
+    for (size_t overflow_idx = 0; overflow_idx <= LEN; overflow_idx++) {
+        for (size_t n = 0; n <= LEN; n++) {
+            fill_inputs64(first, second, overflow_idx, overflow_pair);
+            size_t expected_idx = n;
+            size_t actual_idx = target(first, second, out, n);
+            for (size_t i = 0; i < n; i++) {
+                int64_t expected;
+                if (scalar(first[i], second[i], &expected) && expected_idx == n)
+                    expected_idx = i;
+                cr_assert(eq(i64, out[i], expected), "%s: element %zu of %zu", name, i, n);
+            }
+            cr_assert(eq(sz, actual_idx, expected_idx), "%s: overflow at %zu of %zu", name, overflow_idx, n);
+            cr_assert(eq(sz, expected_idx, overflow_idx < n ? overflow_idx : n), "%s: bad test inputs", name);
+        }
+    }
+    fill_inputs64(first, second, 5, overflow_pair);
+    cr_assert(eq(sz, target(first, second, first, LEN), 5), "%s: in place", name);
+}
+
+Test(intvec, elementwise32) {
+    check_elementwise32("add32s", plain_intvec_add32s, plain_int_overflowing_add32s, INT32_MAX, 1);
+    check_elementwise32("sub32s", plain_intvec_sub32s, plain_int_overflowing_sub32s, INT32_MIN, 1);
+    check_elementwise32("mul32s", plain_intvec_mul32s, plain_int_overflowing_mul32s, INT32_MIN, -1);
+    check_elementwise32("mul32s", plain_intvec_mul32s, plain_int_overflowing_mul32s, 65536, -32769);
+}
+
+Test(intvec, elementwise64) {
+    check_elementwise64("add64s", plain_intvec_add64s, plain_int_overflowing_add64s, INT64_MAX, 1);
+    check_elementwise64("sub64s", plain_intvec_sub64s, plain_int_overflowing_sub64s, INT64_MIN, 1);
+    check_elementwise64("mul64s", plain_intvec_mul64s, plain_int_overflowing_mul64s, INT64_MIN, -1);
+}
+
+Test(intvec, sum64s) {
+    int64_t values[LEN];
+    int64_t res;
+    for (size_t i = 0; i < LEN; i++)
+        values[i] = (int64_t) i - 10;
+    cr_assert(not(plain_intvec_sum64s(values, LEN, &res)));
+    cr_assert(eq(i64, res, (36 * 37) / 2 - 370));
+    cr_assert(not(plain_intvec_sum64s(values, 0, &res)));
+    cr_assert(eq(i64, res, 0));
+    // Intermediate overflow that cancels out is fine
+    for (size_t i = 0; i < LEN; i++)
+        values[i] = (i % 2 == 0) ? INT64_MAX : INT64_MIN + 1;
+    cr_assert(not(plain_intvec_sum64s(values, LEN, &res)));
+    cr_assert(eq(i64, res, INT64_MAX));
+    values[LEN - 2] = INT64_MAX;
+    cr_assert(plain_intvec_sum64s(values, LEN, &res));
+    // Overflowing downwards
+    for (size_t i = 0; i < LEN; i++)
+        values[i] = INT64_MIN;
+    cr_assert(not(plain_intvec_sum64s(values, 1, &res)));
+    cr_assert(plain_intvec_sum64s(values, 2, &res));
+    cr_assert(eq(i64, res, 0)); // Wrapped
+    cr_assert(plain_intvec_sum64s(values, LEN, &res));
+    cr_assert(eq(i64, res, INT64_MIN));
+}
+
+Test(intvec, sum64u) {
+    uint64_t values[LEN];
+    uint64_t res;
+    for (size_t i = 0; i < LEN; i++)
+        values[i] = UINT64_MAX / LEN;
+    cr_assert(not(plain_intvec_sum64u(values, LEN, &res)));
+    cr_assert(eq(u64, res, (UINT64_MAX / LEN) * LEN));
+    values[LEN / 2] = UINT64_MAX;
+    cr_assert(plain_intvec_sum64u(values, LEN, &res));
+    cr_assert(eq(u64, res, (UINT64_MAX / LEN) * (LEN - 1) - 1));
+}
+
+Test(intvec, sum32s) {
+    int32_t values[LEN];
+    int64_t expected = 0;
+    for (size_t i = 0; i < LEN; i++) {
+        values[i] = (i % 3 == 0) ? INT32_MIN : INT32_MAX;
+        expected += values[i];
+    }
+    for (size_t n = 0; n <= LEN; n++) {
+        int64_t prefix = 0;
+        for (size_t i = 0; i < n; i++)
+            prefix += values[i];
+        cr_assert(eq(i64, plain_intvec_sum32s(values, n), prefix), "n = %zu", n);
+    }
+    cr_assert(eq(i64, plain_intvec_sum32s(values, LEN), expected));
+}
+
+Test(intvec, dot32s) {
+    int32_t first[LEN], second[LEN];
+    int64_t res;
+    int64_t expected = 0;
+    for (size_t i = 0; i < LEN; i++) {
+        first[i] = (int32_t) i * 1000 - 7;
+        second[i] = 3 - (int32_t) i * 77;
+        expected += ((int64_t) first[i]) * second[i];
+    }
+    cr_assert(not(plain_intvec_dot32s(first, second, LEN, &res)));
+    cr_assert(eq(i64, res, expected));
+    // Each product is 2^62, so the sum overflows after two of them
+    for (size_t i = 0; i < LEN; i++) {
+        first[i] = INT32_MIN;
+        second[i] = INT32_MIN;
+    }
+    cr_assert(not(plain_intvec_dot32s(first, second, 1, &res)));
+    cr_assert(eq(i64, res, INT64_C(1) << 62));
+    cr_assert(plain_intvec_dot32s(first, second, 2, &res));
+    cr_assert(eq(i64, res, INT64_MIN));
+    cr_assert(plain_intvec_dot32s(first, second, LEN, &res));
+    // Cancelling out is fine
+    for (size_t i = 0; i < LEN; i++)
+        second[i] = (i % 2 == 0) ? INT32_MIN : INT32_MAX;
+    cr_assert(not(plain_intvec_dot32s(first, second, LEN - 1, &res)));
+    cr_assert(eq(i64, res, INT64_C(-2147483648) * -18));
+}